@@ -1,4 +1,6 @@
-﻿using System.Diagnostics;
+﻿using System;
+using System.Diagnostics;
+using System.Linq;
 using System.Runtime.InteropServices;
 using System.Text;
 
@@ -6,12 +8,25 @@ namespace PerfectClearNET {
     static class Interface {
         private static bool abort = false;
 
+        // A search started while the database is generated waits for it instead of aborting it
+        private static bool generating = false;
+
         private delegate bool Callback();
         private static Callback AbortCallback;
 
         [DllImport("sfinder-dll.dll")]
         private static extern void set_abort(Callback func);
 
+        public delegate void SolutionCallback(string solution);
+        private static SolutionCallback SolutionFoundCallback;
+
+        [DllImport("sfinder-dll.dll")]
+        private static extern void set_solution_callback(SolutionCallback func);
+
+        // Same as kMaxTopK in the finder
+        private const uint MaxTopK = 100;
+        private static uint topK = 1;
+
         private static object locker = new object();
         public static bool Running { get; private set; } = false;
 
@@ -22,26 +37,112 @@ namespace PerfectClearNET {
         public static extern void set_threads(uint threads);
 
         [DllImport("sfinder-dll.dll")]
-        private static extern void action(
+        public static extern void set_thread_placement(bool pin, bool reserve_core);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern void set_table_size(uint megabytes);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern void set_timeout(uint milliseconds);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern void set_speculative(bool enabled);
+
+        [DllImport("sfinder-dll.dll")]
+        private static extern void set_top_k(uint count);
+
+        [DllImport("sfinder-dll.dll")]
+        private static extern int get_solutions(StringBuilder str, int len);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern void get_move_cache_stats(out ulong hits, out ulong misses);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern void get_arena_growth(out ulong searches, out ulong growths);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern void get_search_stats(out SearchStats stats);
+
+        [DllImport("sfinder-dll.dll")]
+        private static extern void get_query_times(out QueryTimes times);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern ulong get_latency_percentile(double percentile);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern int get_latency_histogram(ulong[] upper_bounds, ulong[] counts, int length);
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern void reset_latency_histogram();
+
+        [DllImport("sfinder-dll.dll")]
+        public static extern void set_tracing(bool enabled);
+
+        [DllImport("sfinder-dll.dll")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool dump_trace(string path);
+
+        [DllImport("sfinder-dll.dll")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        public static extern bool load_database(string path);
+
+        [DllImport("sfinder-dll.dll")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        private static extern bool generate_database(
+            string path, string field, int height, int pieces, int searchtype,
+            bool hold_empty, bool swap, int combo, bool b2b
+        );
+
+        [DllImport("sfinder-dll.dll")]
+        private static extern void cancel_search();
+
+        [DllImport("sfinder-dll.dll")]
+        private static extern void reset_cancel();
+
+        [DllImport("sfinder-dll.dll")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        private static extern bool action(
             string field, string queue, string hold, int height,
             int max_height, bool swap, int searchtype, int combo, bool b2b, bool two_line,
             StringBuilder str, int len
         );
 
+        [DllImport("sfinder-dll.dll")]
+        [return: MarshalAs(UnmanagedType.I1)]
+        private static extern bool action_anytime(
+            string field, string queue, string hold, int height,
+            int max_height, bool swap, int searchtype, int combo, bool b2b, bool two_line,
+            StringBuilder str, int len, uint milliseconds
+        );
+
         static Interface() {
             AbortCallback = new Callback(Abort);
             set_abort(AbortCallback);
         }
 
-        public static bool Abort() => abort;
+        public static void SetTopK(uint count) {
+            topK = Math.Min(Math.Max(count, 1), MaxTopK);
+            set_top_k(topK);
+        }
+
+        // Keeps the delegate alive while the finder holds it
+        public static void SetSolutionCallback(SolutionCallback callback) {
+            SolutionFoundCallback = callback;
+            set_solution_callback(callback);
+        }
+
+        public static bool Abort() => abort && !generating;
         public static void SetAbort() {
-            if (Running) abort = true;
+            if (Running) {
+                abort = true;
+                cancel_search();
+            }
         }
 
         public static string Process(
             string field, string queue, string hold, int height,
             int max_height, bool swap, int search_type, int combo, bool b2b, bool two_line,
-            out long time
+            uint budget, out long time, out bool optimal, out QueryTimes times, out string[] solutions
         ) {
 
             StringBuilder sb = new StringBuilder(500);
@@ -51,24 +152,61 @@ namespace PerfectClearNET {
             lock (locker) {
                 abort = false;
 
+                // SetAbort cannot cancel until Running is set, so only a late cancel of the previous query is cleared
+                reset_cancel();
+
                 Stopwatch stopwatch = new Stopwatch();
                 stopwatch.Start();
 
                 Running = true;
 
-                action(
-                    field, queue, hold, height,
-                    max_height, swap, search_type, combo, b2b, two_line,
-                    sb, sb.Capacity
-                );
+                optimal = budget > 0
+                    ? action_anytime(
+                        field, queue, hold, height,
+                        max_height, swap, search_type, combo, b2b, two_line,
+                        sb, sb.Capacity, budget
+                    )
+                    : action(
+                        field, queue, hold, height,
+                        max_height, swap, search_type, combo, b2b, two_line,
+                        sb, sb.Capacity
+                    );
 
                 Running = false;
 
                 stopwatch.Stop();
                 time = stopwatch.ElapsedMilliseconds;
+
+                get_query_times(out times);
+
+                StringBuilder all = new StringBuilder((int)(500 * topK));
+                int count = get_solutions(all, all.Capacity);
+                solutions = all.ToString().Split(new char[] { ';' }, StringSplitOptions.RemoveEmptyEntries).Take(count).ToArray();
             }
 
             return sb.ToString();
         }
+
+        public static bool GenerateDatabase(
+            string path, string field, int height, int pieces, int search_type,
+            bool hold_empty, bool swap, int combo, bool b2b
+        ) {
+            // Unlike Process, waits for the running search instead of aborting it
+            lock (locker) {
+                abort = false;
+
+                reset_cancel();
+
+                generating = true;
+                Running = true;
+
+                bool generated = generate_database(path, field, height, pieces, search_type, hold_empty, swap, combo, b2b);
+
+                Running = false;
+                generating = false;
+
+                return generated;
+            }
+        }
     }
 }
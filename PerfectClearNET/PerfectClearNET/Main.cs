@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Collections.Generic;
+using System.Linq;
 using System.Threading;
 using System.Threading.Tasks;
 
@@ -42,17 +43,54 @@ namespace PerfectClearNET {
         /// </summary>
         public static List<Operation> LastSolution = new List<Operation>();
 
+        /// <summary>
+        /// The best distinct solutions of the latest search, from the best, as many as set by SetTopK. The first one is LastSolution.
+        /// </summary>
+        public static List<List<Operation>> LastSolutions = new List<List<Operation>>();
+
+        /// <param name="solution">The solution that was found.</param>
+        public delegate void SolutionFoundEventHandler(List<Operation> solution);
+
+        private static SolutionFoundEventHandler solutionFound;
+
+        /// <summary>
+        /// <para>Fires with each solution as soon as the search finds it, before the search ends. Solutions come in the order they are found, not the best first.</para>
+        /// <para>Fires on the threads of the finder, one call at a time, and slows the search down while it runs.</para>
+        /// </summary>
+        public static event SolutionFoundEventHandler SolutionFound {
+            add { solutionFound += value; }
+            remove { solutionFound -= value; }
+        }
+
+        // Registered once and never replaced, since a running search may still call it after the last handler is removed
+        private static readonly Interface.SolutionCallback SolutionFoundCallback = OnSolutionFound;
+
+        static void OnSolutionFound(string solution) => solutionFound?.Invoke(ParseSolution(solution));
+
         /// <summary>
         /// The amount of time the latest search took to complete.
         /// </summary>
         public static long LastTime = 0;
 
+        /// <summary>
+        /// Where the time of the latest search went, in nanoseconds.
+        /// </summary>
+        public static QueryTimes LastQueryTimes = new QueryTimes();
+
+        /// <summary>
+        /// Whether the latest search ran to the end, so LastSolution is the best one (or no solution exists).
+        /// False if the search was aborted or ran out of time, in which case LastSolution is the best solution found before then.
+        /// </summary>
+        public static bool LastOptimal = false;
+
         /// <summary>
         /// Checks if the Perfect Clear Finder is currently searching for solutions.
         /// </summary>
         public static bool Running { get => Interface.Running; }
 
-        static PerfectClear() {}
+        static PerfectClear() {
+            Interface.SetSolutionCallback(SolutionFoundCallback);
+        }
 
         /// <summary>
         /// Aborts the currently running search, if there is one.
@@ -81,17 +119,177 @@ namespace PerfectClearNET {
         }
 
         /// <summary>
-        /// Changes the thread count.
+        /// Changes the thread count. A running search goes on: added threads join it, and removed threads leave it after their current task.
         /// </summary>
-        /// <param name="threads">Specifies the number of threads to search with.</param>
+        /// <param name="threads">Specifies the number of threads to search with. 0 uses one thread per hardware thread, less the one reserved by SetThreadPlacement.</param>
         public static void SetThreads(uint threads) => Interface.set_threads(threads);
 
+        /// <summary>
+        /// Changes where the search threads run.
+        /// </summary>
+        /// <param name="pin">Specifies if each thread should be pinned to its own hardware thread.</param>
+        /// <param name="reserveCore">Specifies if the first hardware thread should be left to the caller. Enabled by default.</param>
+        public static void SetThreadPlacement(bool pin, bool reserveCore) => Interface.set_thread_placement(pin, reserveCore);
+
+        /// <summary>
+        /// Changes the memory budget of the table which remembers dead search states. 0 disables the table.
+        /// Waits for the running search to finish.
+        /// </summary>
+        /// <param name="megabytes">Specifies the size of the table in megabytes.</param>
+        public static void SetTableSize(uint megabytes) => Interface.set_table_size(megabytes);
+
+        /// <summary>
+        /// Changes the time limit of each search. The search gives up when the time runs out. 0 disables the limit.
+        /// </summary>
+        /// <param name="milliseconds">Specifies the time limit in milliseconds.</param>
+        public static void SetTimeout(uint milliseconds) => Interface.set_timeout(milliseconds);
+
+        /// <summary>
+        /// Changes whether all heights up to the maximum height are searched at the same time instead of one after another.
+        /// The lowest height with a solution still wins, and the higher ones are cancelled as soon as it is found.
+        /// </summary>
+        /// <param name="enabled">Specifies if the heights should be searched at the same time.</param>
+        public static void SetSpeculative(bool enabled) => Interface.set_speculative(enabled);
+
+        /// <summary>
+        /// Changes how many of the best distinct solutions each search keeps in LastSolutions. Defaults to 1, and at most 100 are kept.
+        /// Keeping more prunes less, so searches take longer.
+        /// </summary>
+        /// <param name="count">Specifies the number of solutions to keep.</param>
+        public static void SetTopK(uint count) => Interface.SetTopK(count);
+
+        /// <summary>
+        /// Gets how many move generations were answered by the move cache, since the finder was loaded.
+        /// </summary>
+        /// <param name="hits">The number of move lists found in the cache.</param>
+        /// <param name="misses">The number of move lists generated.</param>
+        public static void GetMoveCacheStats(out ulong hits, out ulong misses) => Interface.get_move_cache_stats(out hits, out misses);
+
+        /// <summary>
+        /// Gets how many times the search arena grew, since the finder was loaded.
+        /// Once warm, repeated searches do not grow it, however many nodes they visit. It does not count the other heap allocations of a search.
+        /// </summary>
+        /// <param name="searches">The number of searches run by the threads.</param>
+        /// <param name="growths">The number of move buffers grown and task payloads created.</param>
+        public static void GetArenaGrowth(out ulong searches, out ulong growths) => Interface.get_arena_growth(out searches, out growths);
+
+        /// <summary>
+        /// Gets what the searches have done since the finder was loaded: nodes per depth, moves, prunes and the time in each phase.
+        /// Subtract two snapshots to see what a single search did.
+        /// </summary>
+        /// <returns>The counters summed over all threads.</returns>
+        public static SearchStats GetSearchStats() {
+            Interface.get_search_stats(out SearchStats stats);
+            return stats;
+        }
+
+        /// <summary>
+        /// Gets a latency percentile of the recent searches, between the latest 1024 and 2048 of them.
+        /// </summary>
+        /// <param name="percentile">Specifies the percentile, from 0 to 100.</param>
+        /// <returns>The latency in nanoseconds, within 1/16 of the actual one. 0 if no search has run.</returns>
+        public static ulong GetLatencyPercentile(double percentile) => Interface.get_latency_percentile(percentile);
+
+        /// <summary>
+        /// Gets the latency histogram of the recent searches, between the latest 1024 and 2048 of them.
+        /// </summary>
+        /// <param name="upperBounds">The largest latency in nanoseconds counted by each non-empty bucket, from the fastest.</param>
+        /// <param name="counts">The number of searches in each bucket.</param>
+        public static void GetLatencyHistogram(out ulong[] upperBounds, out ulong[] counts) {
+            ulong[] bounds = new ulong[1024];
+            ulong[] buckets = new ulong[1024];
+            int length = Interface.get_latency_histogram(bounds, buckets, bounds.Length);
+
+            upperBounds = bounds.Take(length).ToArray();
+            counts = buckets.Take(length).ToArray();
+        }
+
+        /// <summary>
+        /// Forgets the latencies of the previous searches.
+        /// </summary>
+        public static void ResetLatencyHistogram() => Interface.reset_latency_histogram();
+
+        /// <summary>
+        /// Changes whether the finder records when its tasks are queued, started and finished by each thread.
+        /// </summary>
+        /// <param name="enabled">Specifies if the schedule should be recorded.</param>
+        public static void SetTracing(bool enabled) => Interface.set_tracing(enabled);
+
+        /// <summary>
+        /// Writes the schedule of the latest search as a Chrome trace JSON file, to be opened in chrome://tracing or Perfetto.
+        /// Needs SetTracing(true) before the search, and must be called after it finishes.
+        /// </summary>
+        /// <param name="path">The path to the file to write.</param>
+        /// <returns>Whether the file was written.</returns>
+        public static bool DumpTrace(string path) => Interface.dump_trace(path);
+
+        /// <summary>
+        /// Loads a database of precomputed solutions made by GenerateDatabase. Searches it covers are answered without searching.
+        /// Must be called after Initialize, with a database generated for the same game. Waits for the running search to finish.
+        /// </summary>
+        /// <param name="path">The path to the database file.</param>
+        /// <returns>Whether the database was loaded.</returns>
+        public static bool LoadDatabase(string path) => Interface.load_database(path);
+
+        /// <summary>
+        /// <para>Searches every queue of the given length on the field and appends the solutions to a database file, which is created if missing.</para>
+        /// <para>A queue of n pieces has 7^n entries, so only short queues are practical. This closes the loaded database, and blocks until done.</para>
+        /// <para>Waits for the running search to finish first. Searches started meanwhile wait for the generation instead of aborting it, and Abort stops it.</para>
+        /// </summary>
+        /// <param name="path">The path to the database file.</param>
+        /// <param name="field">The field, formatted as in Find.</param>
+        /// <param name="height">The height of the Perfect Clear.</param>
+        /// <param name="pieces">The length of the queues including the hold piece: the number of pieces to place, or one more to leave one in hold.</param>
+        /// <param name="holdEmpty">Whether the first piece of the queues is the current piece instead of the piece in hold.</param>
+        /// <param name="swap">Same as in Find.</param>
+        /// <param name="searchType">Same as in Find.</param>
+        /// <param name="combo">Same as in Find.</param>
+        /// <param name="b2b">Same as in Find.</param>
+        /// <returns>Whether the section was generated. It is not if the file cannot be written or the search was aborted.</returns>
+        public static bool GenerateDatabase(
+            string path, int[,] field, int height, int pieces, bool holdEmpty,
+            bool swap, SearchType searchType, int combo, bool b2b
+        ) {
+            bool generated = Interface.GenerateDatabase(path, EncodeField(field, out _), height, pieces, (int)searchType, holdEmpty, swap, combo, b2b);
+
+            AbortCoordinator.WakeWaiters();
+
+            return generated;
+        }
+
+        static string EncodeField(int[,] field, out int top) {
+            top = -1;
+            string f = "";
+
+            for (int i = 19; i >= 0; i--)
+                for (int j = 0; j < 10; j++) {
+                    if (field[j, i] == 255) {
+                        f += '_';
+                    } else {
+                        f += 'X';
+                        if (top == -1) top = i + 1;
+                    }
+                }
+
+            return f;
+        }
+
+        static List<Operation> ParseSolution(string solution) {
+            List<Operation> operations = new List<Operation>();
+
+            foreach (string op in solution.Split('|'))
+                if (op != "" && op != "0,-1,-1,0")
+                    operations.Add(new Operation(op));
+
+            return operations;
+        }
+
         /// <summary>
         /// <para>Starts searching for a solution/decision for the given game state.</para>
         /// <para>Pieces should be formatted with numbers from 0 to 6 in the order of SZJLTOI. Empty state on the field should be formatted with 255.</para>
         /// <para>Since this method will begin a search in the background, it does not immediately return any data.</para>
-        /// <para>When the search ends, the Finished event will fire and LastSolution will update.</para>
-        /// <para>The search can be ended prematurely with the Abort method.</para>
+        /// <para>When the search ends, the Finished event will fire and LastSolution and LastSolutions will update.</para>
+        /// <para>The search can be ended prematurely with the Abort method. While GenerateDatabase runs, the search waits for it to finish.</para>
         /// </summary>
         /// <param name="field">A 2D array consisting of the field. Should be no smaller than int[10, height].</param>
         /// <param name="queue">The piece queue, can be of any size.</param>
@@ -104,25 +302,22 @@ namespace PerfectClearNET {
         /// <param name="combo">The combo count.</param>
         /// <param name="b2b">Do you have back-to-back?</param>
         /// <param name="two_line">Whether to optimize the current Perfect Clear for a two-line follow-up.</param>
-        public static async void Find(
+        public static void Find(
             int[,] field, int[] queue, int current, int? hold, bool holdAllowed,
             int maxHeight, bool swap, SearchType searchType, int combo, bool b2b, bool two_line
-        ) {
+        ) => Find(field, queue, current, hold, holdAllowed, maxHeight, swap, searchType, combo, b2b, two_line, 0);
 
-            int c = 0;
-            int t = -1;
-            string f = "";
+        /// <summary>
+        /// <para>Same as Find, but stops after the time budget and reports the best solution found until then.</para>
+        /// <para>LastOptimal tells whether the search finished within the budget.</para>
+        /// </summary>
+        /// <param name="budget">The time budget in milliseconds. 0 falls back to the time limit set by SetTimeout.</param>
+        public static async void Find(
+            int[,] field, int[] queue, int current, int? hold, bool holdAllowed,
+            int maxHeight, bool swap, SearchType searchType, int combo, bool b2b, bool two_line, uint budget
+        ) {
 
-            for (int i = 19; i >= 0; i--)
-                for (int j = 0; j < 10; j++) {
-                    if (field[j, i] == 255) {
-                        f += '_';
-                        c += 1;
-                    } else {
-                        f += 'X';
-                        if (t == -1) t = i + 1;
-                    }
-                }
+            string f = EncodeField(field, out int t);
 
             if (t == -1) t = 2;
 
@@ -137,18 +332,17 @@ namespace PerfectClearNET {
             string result = "";
 
             await Task.Run(() => {
-                result = Interface.Process(f, q, h, t, maxHeight, swap, (int)searchType, combo, b2b, two_line, out long time);
+                result = Interface.Process(f, q, h, t, maxHeight, swap, (int)searchType, combo, b2b, two_line, budget, out long time, out bool optimal, out QueryTimes times, out string[] solutions);
 
                 LastSolution = new List<Operation>();
                 LastTime = time;
+                LastQueryTimes = times;
+                LastOptimal = optimal;
 
                 bool solved = !result.Equals("-1");
 
-                if (solved) {
-                    foreach (string op in result.Split('|'))
-                        if (op != "" && op != "0,-1,-1,0")
-                            LastSolution.Add(new Operation(op));
-                }
+                if (solved) LastSolution = ParseSolution(result);
+                LastSolutions = solutions.Select(ParseSolution).ToList();
 
                 Finished?.Invoke(solved);
 
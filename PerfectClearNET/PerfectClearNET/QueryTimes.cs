@@ -0,0 +1,65 @@
+﻿using System.Runtime.InteropServices;
+
+namespace PerfectClearNET {
+    /// <summary>
+    /// Where the time of one search went, in nanoseconds.
+    /// The phases run one after another, while QueueWait is summed over the tasks run by the threads.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct QueryTimes {
+        /// <summary>
+        /// The whole time of the search, measured inside the finder.
+        /// </summary>
+        public ulong Total;
+
+        /// <summary>
+        /// The time spent reading the field and the queue, and choosing the heights.
+        /// </summary>
+        public ulong Parse;
+
+        /// <summary>
+        /// The time spent looking the heights up in the database.
+        /// </summary>
+        public ulong Lookup;
+
+        /// <summary>
+        /// The time spent generating the first moves.
+        /// </summary>
+        public ulong Premove;
+
+        /// <summary>
+        /// The time spent queueing the tasks of the first moves.
+        /// </summary>
+        public ulong Dispatch;
+
+        /// <summary>
+        /// The time spent waiting for the tasks to finish.
+        /// </summary>
+        public ulong Search;
+
+        /// <summary>
+        /// The time spent writing the solution.
+        /// </summary>
+        public ulong Format;
+
+        /// <summary>
+        /// The time the tasks waited in the queue before a thread started them, summed over the tasks.
+        /// </summary>
+        public ulong QueueWait;
+
+        /// <summary>
+        /// The longest time a task waited in the queue.
+        /// </summary>
+        public ulong MaxQueueWait;
+
+        /// <summary>
+        /// The number of tasks run.
+        /// </summary>
+        public ulong Tasks;
+
+        /// <summary>
+        /// The number of heights searched.
+        /// </summary>
+        public ulong Heights;
+    }
+}
@@ -0,0 +1,82 @@
+﻿using System.Runtime.InteropServices;
+
+namespace PerfectClearNET {
+    /// <summary>
+    /// What the searches of all threads have done since the finder was loaded. Times are in nanoseconds, summed over the threads.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchStats {
+        /// <summary>
+        /// The deepest depth counted separately in NodesPerDepth. Deeper nodes are counted in the last element.
+        /// </summary>
+        public const int MaxDepth = 50;
+
+        /// <summary>
+        /// Gets whether the finder was built with the counters. All counts are 0 otherwise.
+        /// </summary>
+        public bool Enabled => enabled != 0;
+
+        private ulong enabled;
+
+        /// <summary>
+        /// The number of states searched.
+        /// </summary>
+        public ulong Nodes;
+
+        /// <summary>
+        /// The number of states searched at each depth, i.e. after placing that many pieces.
+        /// </summary>
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = MaxDepth)]
+        public ulong[] NodesPerDepth;
+
+        /// <summary>
+        /// The number of moves generated.
+        /// </summary>
+        public ulong Moves;
+
+        /// <summary>
+        /// The number of fields rejected because their empty cells cannot be filled with pieces.
+        /// </summary>
+        public ulong ValidateRejections;
+
+        /// <summary>
+        /// The number of states pruned because they cannot beat the best solution of their own search.
+        /// </summary>
+        public ulong Prunes;
+
+        /// <summary>
+        /// The number of states pruned because they cannot beat the best solution found by another thread.
+        /// </summary>
+        public ulong SharedPrunes;
+
+        /// <summary>
+        /// The number of placements checked for a spin.
+        /// </summary>
+        public ulong SpinChecks;
+
+        /// <summary>
+        /// The number of times a better solution was recorded.
+        /// </summary>
+        public ulong RecorderUpdates;
+
+        /// <summary>
+        /// The time spent generating moves. 0 unless the finder was built with FINDER_PHASE_TIMES=1.
+        /// </summary>
+        public ulong MoveGenerationTime;
+
+        /// <summary>
+        /// The time spent scoring and sorting moves. 0 unless the finder was built with FINDER_PHASE_TIMES=1.
+        /// </summary>
+        public ulong OrderingTime;
+
+        /// <summary>
+        /// The time spent checking spins. 0 unless the finder was built with FINDER_PHASE_TIMES=1.
+        /// </summary>
+        public ulong SpinCheckTime;
+
+        /// <summary>
+        /// The whole time spent searching, including the other phases.
+        /// </summary>
+        public ulong SearchTime;
+    }
+}
@@ -0,0 +1,542 @@
+// Benchmark of the finder on a corpus of queries. It links the finder sources directly, without the DLL.
+//
+// Usage: sfinder-bench [options] <corpus>
+//   --game ppt|tetrio     Rotation system and game rules (default: ppt)
+//   --threads 1,2,4       Thread counts to run the corpus with, one after another; 0 is one per hardware thread (default: 1)
+//   --repeat N            Runs of the corpus per thread count. The first run also warms up the caches (default: 1)
+//   --timeout MS          Gives up each query after MS milliseconds. 0 means no timeout (default: 0)
+//   --table MB            Size of the transposition table. 0 disables it (default: 32)
+//   --verbose             Prints each query
+//   --check-growth        Fails if a run after the first grows the search arena. Run it with one thread and no timeout:
+//                         otherwise the tasks each thread runs change between runs, and so the move lists its buffers hold
+//
+// Usage: sfinder-bench --collision
+//   Times the collision kernel of the move generator against the portable one, for fields of 2 to 24 rows,
+//   and checks that they agree. The kernel is the AVX2 one if the CPU has it.
+//
+// Usage: sfinder-bench --generate N [--seed S]
+//   Writes a corpus of N random queries to the standard output.
+//   Queues are 7-bag. Fields are empty with 2 lines to clear, or residues of a few pieces dropped without holes with 4 lines.
+//
+// A corpus has a query per line: `<field> <queue> <hold> <height> <search type>`. `#` starts a comment.
+//   field        Rows of 10 cells from the top, `X` for a block and `_` for an empty cell. `-` for an empty field
+//   queue        Next pieces, e.g. `TIJLOSZ`
+//   hold         A piece, `E` if the hold is empty, or `X` if hold is not allowed
+//   height       The number of lines to clear
+//   search type  The code passed to `action()`
+//
+// For each thread count and search mode, it reports queries per second, p50/p99 latency,
+// nodes searched per second and time to the first solution.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "callback.hpp"
+#include "core/collision.hpp"
+#include "core/field.hpp"
+#include "core/flood_moves.hpp"
+#include "core/piece.hpp"
+#include "finder/cancellation.hpp"
+#include "finder/concurrent_perfect_clear.hpp"
+#include "finder/move_cache.hpp"
+#include "finder/pc_database.hpp"
+#include "finder/search_arena.hpp"
+#include "finder/search_stats.hpp"
+#include "finder/thread_pool.hpp"
+#include "finder/transposition_table.hpp"
+
+namespace {
+    using PPTFinder = finder::ConcurrentPerfectClearFinder<false, true, finder::CachedMoveGenerator<core::srs_flood::MoveGenerator<false, true>>>;
+    using TETRIOFinder = finder::ConcurrentPerfectClearFinder<true, false, finder::CachedMoveGenerator<core::srs_flood::MoveGenerator<true, false>>>;
+
+    struct Query {
+        std::string fieldMarks;
+        std::string queue;
+        char hold;
+        int height;
+        int searchType;
+    };
+
+    struct Options {
+        std::string game = "ppt";
+        std::vector<int> threads = {1};
+        int repeat = 1;
+        unsigned int timeout = 0;
+        unsigned int table = finder::TranspositionTable::kDefaultMegabytes;
+        bool verbose = false;
+        bool checkGrowth = false;
+        std::string corpus;
+        int generate = 0;
+        unsigned int seed = 1;
+        bool collision = false;
+    };
+
+    struct Sample {
+        double latency;
+        double firstSolution;  // Negative if no solution is found
+        uint64_t nodes;
+        bool finished;
+    };
+
+    const char *const kPieceNames = "TILJSZO";
+
+    core::PieceType toPiece(char name) {
+        auto found = std::string(kPieceNames).find(name);
+        if (found == std::string::npos) {
+            throw std::runtime_error(std::string("Illegal piece: ") + name);
+        }
+        return static_cast<core::PieceType>(found);
+    }
+
+    // Mode of `SearchTypes` that a search type code runs
+    const char *modeName(int searchType) {
+        switch (searchType) {
+            case 0:
+                return "Fast";
+            case 1:
+                return "TSpin";
+            case 2:
+            case 3:
+                return "AllSpins";
+            case 4:
+                return "TETRIOS2";
+            default:
+                return "Unknown";
+        }
+    }
+
+    std::vector<Query> loadCorpus(const std::string &path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open the corpus: " + path);
+        }
+
+        std::vector<Query> queries{};
+        std::string line;
+        while (std::getline(file, line)) {
+            auto comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+
+            std::istringstream stream(line);
+            Query query{};
+            std::string hold;
+            if (!(stream >> query.fieldMarks)) {
+                continue;
+            }
+            if (!(stream >> query.queue >> hold >> query.height >> query.searchType) || hold.size() != 1) {
+                throw std::runtime_error("Illegal query: " + line);
+            }
+
+            if (query.fieldMarks == "-") {
+                query.fieldMarks.clear();
+            }
+            query.hold = hold[0];
+            queries.push_back(query);
+        }
+
+        return queries;
+    }
+
+    // Percentile by the nearest rank. `values` must be sorted
+    double percentile(const std::vector<double> &values, double rank) {
+        if (values.empty()) {
+            return 0.0;
+        }
+
+        auto index = static_cast<size_t>(rank * static_cast<double>(values.size()) + 0.999999);
+        return values[std::min(values.size(), std::max<size_t>(index, 1)) - 1];
+    }
+
+    void report(int threads, const std::string &mode, const std::vector<Sample> &samples) {
+        if (samples.empty()) {
+            return;
+        }
+
+        std::vector<double> latencies{};
+        std::vector<double> firstSolutions{};
+        double total = 0.0;
+        uint64_t nodes = 0;
+        int solved = 0;
+        int unfinished = 0;
+        for (const auto &sample : samples) {
+            latencies.push_back(sample.latency);
+            total += sample.latency;
+            nodes += sample.nodes;
+            if (0.0 <= sample.firstSolution) {
+                firstSolutions.push_back(sample.firstSolution);
+                solved += 1;
+            }
+            if (!sample.finished) {
+                unfinished += 1;
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+        std::sort(firstSolutions.begin(), firstSolutions.end());
+
+        double seconds = total / 1000.0;
+        std::printf(
+                "%7d  %-8s  %7zu  %6d  %8d  %9.2f  %9.2f  %9.2f  %10.2f  %12.0f\n",
+                threads, mode.c_str(), samples.size(), solved, unfinished,
+                0.0 < seconds ? static_cast<double>(samples.size()) / seconds : 0.0,
+                percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(firstSolutions, 0.5),
+                0.0 < seconds ? static_cast<double>(nodes) / seconds : 0.0
+        );
+    }
+
+    // Returns false if `--check-growth` failed
+    template<class F>
+    bool run(const Options &options, const core::Factory &factory, const std::vector<Query> &queries) {
+        bool warm = true;
+
+        std::printf(
+                "%7s  %-8s  %7s  %6s  %8s  %9s  %9s  %9s  %10s  %12s\n",
+                "threads", "mode", "queries", "solved", "timeouts", "qps", "p50 ms", "p99 ms", "ttfs p50", "nodes/s"
+        );
+
+        for (int threads : options.threads) {
+            auto threadPool = finder::ThreadPool(threads);
+            auto table = finder::TranspositionTable(options.table);
+            finder::CancellationToken token{};
+            finder::PCDatabase database{};
+            auto pcFinder = F(factory, threadPool, table, token, database);
+
+            std::vector<std::pair<std::string, Sample>> samples{};
+            for (int run = 0; run < options.repeat; ++run) {
+                auto growthsBefore = finder::ArenaGrowth::stats().growths;
+
+                for (const auto &query : queries) {
+                    auto field = core::createField(query.fieldMarks);
+
+                    bool holdEmpty = query.hold == 'E';
+                    bool holdAllowed = query.hold != 'X';
+
+                    auto pieces = std::vector<core::PieceType>();
+                    if (!holdEmpty && holdAllowed) {
+                        pieces.push_back(toPiece(query.hold));
+                    }
+
+                    int maxPieces = (query.height * core::FIELD_WIDTH - field.getNumOfBlocks()) / 4 + 1;
+                    for (int index = 0; index < maxPieces && index < static_cast<int>(query.queue.size()); ++index) {
+                        pieces.push_back(toPiece(query.queue[index]));
+                    }
+
+                    auto before = finder::SearchCounters::stats();
+                    auto start = finder::CancellationToken::now();
+                    token.reset(0 < options.timeout ? start + options.timeout * 1000000LL : 0);
+
+                    auto solution = pcFinder.run(
+                            field, pieces, query.height, holdEmpty, holdAllowed, true, query.searchType,
+                            0, false, false, 6
+                    );
+
+                    auto end = finder::CancellationToken::now();
+                    auto after = finder::SearchCounters::stats();
+
+                    // Answers found without any task, e.g. a single piece, count as found at the end
+                    auto firstTime = pcFinder.firstSolutionTime();
+                    auto sample = Sample{
+                            static_cast<double>(end - start) / 1e6,
+                            solution.empty() ? -1.0 : static_cast<double>((firstTime != 0 ? firstTime : end) - start) / 1e6,
+                            after.nodes - before.nodes,
+                            !token.cancelled(),
+                    };
+                    samples.emplace_back(modeName(query.searchType), sample);
+
+                    if (options.verbose) {
+                        std::fprintf(
+                                stderr, "%s %s %c %d %d: %.2f ms, %llu nodes, %s\n",
+                                query.fieldMarks.empty() ? "-" : query.fieldMarks.c_str(), query.queue.c_str(),
+                                query.hold, query.height, query.searchType, sample.latency,
+                                static_cast<unsigned long long>(sample.nodes),
+                                solution.empty() ? "no solution" : "solved"
+                        );
+                    }
+                }
+
+                auto growths = finder::ArenaGrowth::stats().growths - growthsBefore;
+                if (options.checkGrowth && 0 < run && 0 < growths) {
+                    std::fprintf(
+                            stderr, "Run %d with %d threads grew the search arena %llu times\n",
+                            run + 1, threadPool.size(), static_cast<unsigned long long>(growths)
+                    );
+                    warm = false;
+                }
+            }
+
+            std::vector<std::string> modes{};
+            for (const auto &sample : samples) {
+                if (std::find(modes.begin(), modes.end(), sample.first) == modes.end()) {
+                    modes.push_back(sample.first);
+                }
+            }
+
+            std::vector<Sample> all{};
+            for (const auto &mode : modes) {
+                std::vector<Sample> ofMode{};
+                for (const auto &sample : samples) {
+                    if (sample.first == mode) {
+                        ofMode.push_back(sample.second);
+                    }
+                }
+                report(threadPool.size(), mode, ofMode);
+                all.insert(all.end(), ofMode.begin(), ofMode.end());
+            }
+            report(threadPool.size(), "All", all);
+
+            threadPool.shutdown();
+        }
+
+        return warm;
+    }
+
+    // Drops `numOfPieces` random pieces on the field, each at a random one of the placements that keep the stack lowest,
+    // as a player would on the way to a perfect clear. Returns false if a piece can only make a hole or go above 4 lines.
+    bool dropPieces(std::mt19937 &random, const core::Factory &factory, int numOfPieces, core::Field &field) {
+        for (int count = 0; count < numOfPieces; ++count) {
+            auto pieceType = static_cast<core::PieceType>(random() % 7);
+
+            std::vector<core::Field> lowest{};
+            int lowestY = 4;
+            for (int rotate = 0; rotate < 4; ++rotate) {
+                auto &blocks = factory.get(pieceType, static_cast<core::RotateType>(rotate));
+                for (int x = -blocks.minX; x < core::FIELD_WIDTH - blocks.maxX; ++x) {
+                    auto next = core::Field(field);
+                    next.put(blocks, x, next.getYOnHarddrop(blocks, x, core::MAX_FIELD_HEIGHT - 2));
+                    next.clearLine();
+
+                    auto maxY = next.getMaxY();
+                    if (next.getNumOfHoles() != 0 || lowestY < maxY) {
+                        continue;
+                    }
+                    if (maxY < lowestY) {
+                        lowest.clear();
+                        lowestY = maxY;
+                    }
+                    lowest.push_back(next);
+                }
+            }
+
+            if (lowest.empty()) {
+                return false;
+            }
+            field = lowest[random() % lowest.size()];
+        }
+
+        return true;
+    }
+
+    std::string toMarks(const core::Field &field) {
+        std::string marks{};
+        for (int y = field.getMaxY(); 0 <= y; --y) {
+            for (int x = 0; x < core::FIELD_WIDTH; ++x) {
+                marks += field.isEmpty(x, y) ? '_' : 'X';
+            }
+        }
+        return marks.empty() ? "-" : marks;
+    }
+
+    void generate(const Options &options) {
+        std::mt19937 random(options.seed);
+        auto &factory = core::Factory::create();
+
+        std::printf("# Generated by sfinder-bench --generate %d --seed %u\n", options.generate, options.seed);
+
+        for (int index = 0; index < options.generate; ++index) {
+            // Two-line perfect clears on the empty field for a quarter of the queries, and 4-line perfect clears on residues of 2 to 5 pieces for the others
+            core::Field field{};
+            if (index % 4 != 0) {
+                int numOfPieces = 2 + static_cast<int>(random() % 4);
+                do {
+                    field = core::Field{};
+                } while (!dropPieces(random, factory, numOfPieces, field));
+            }
+
+            // The lowest height that the field fits and the pieces can fill
+            int height = std::max(field.getMaxY() + 1, index % 4 == 0 ? 2 : 4);
+            while ((height * core::FIELD_WIDTH - field.getNumOfBlocks()) % 4 != 0) {
+                height += 1;
+            }
+
+            int maxPieces = (height * core::FIELD_WIDTH - field.getNumOfBlocks()) / 4 + 1;
+            std::string queue{};
+            while (static_cast<int>(queue.size()) < maxPieces + 1) {
+                std::string bag = kPieceNames;
+                std::shuffle(bag.begin(), bag.end(), random);
+                queue += bag;
+            }
+
+            char hold = 'E';
+            if (random() % 2 == 0) {
+                hold = queue[0];
+                queue.erase(0, 1);
+            }
+            queue.resize(maxPieces);
+
+            std::printf(
+                    "%s %s %c %d %d\n", toMarks(field).c_str(), queue.c_str(), hold, height, index % 5
+            );
+        }
+    }
+
+    struct Rows {
+        uint32_t rows[core::collision::kPaddedHeight];
+    };
+
+    // Nanoseconds per call of `kernel` over all rotations of all pieces, on random rows
+    template<class K>
+    double timeKernel(K kernel, const core::Factory &factory, const std::vector<Rows> &fields, int numOfRows, uint32_t &checksum) {
+        constexpr int kRounds = 20000;
+
+        uint32_t free[core::MAX_FIELD_HEIGHT]{};
+        auto start = finder::CancellationToken::now();
+        for (int round = 0; round < kRounds; ++round) {
+            auto &rows = fields[round % fields.size()].rows;
+            for (int piece = 0; piece < 7; ++piece) {
+                for (int rotate = 0; rotate < 4; ++rotate) {
+                    auto &blocks = factory.get(static_cast<core::PieceType>(piece), static_cast<core::RotateType>(rotate));
+                    kernel(rows, blocks, numOfRows, free);
+                    checksum = checksum * 31U + free[0] + free[numOfRows - 1];
+                }
+            }
+        }
+        auto end = finder::CancellationToken::now();
+
+        return static_cast<double>(end - start) / (kRounds * 7.0 * 4.0);
+    }
+
+    // Returns false if the kernel disagrees with the portable one
+    bool benchmarkCollision() {
+        auto &factory = core::Factory::create();
+
+        std::mt19937 random(1);
+        std::vector<Rows> fields(64);
+        for (auto &field : fields) {
+            for (int y = 0; y < core::MAX_FIELD_HEIGHT; ++y) {
+                field.rows[y] = random() & 0x3ffU;
+            }
+        }
+
+        std::printf("kernel: %s\n", core::collision::usesAvx2() ? "avx2" : "scalar");
+        std::printf("%4s  %10s  %10s  %7s\n", "rows", "scalar ns", "kernel ns", "speedup");
+
+        for (int numOfRows : {2, 4, 6, 8, 12, 16, 24}) {
+            uint32_t scalarChecksum = 0;
+            uint32_t kernelChecksum = 0;
+            auto scalar = timeKernel(core::collision::getFreeRowsScalar, factory, fields, numOfRows, scalarChecksum);
+            auto kernel = timeKernel(core::collision::getFreeRows, factory, fields, numOfRows, kernelChecksum);
+
+            if (scalarChecksum != kernelChecksum) {
+                std::fprintf(stderr, "The kernel disagrees with the portable one for %d rows\n", numOfRows);
+                return false;
+            }
+
+            std::printf("%4d  %10.2f  %10.2f  %6.2fx\n", numOfRows, scalar, kernel, scalar / kernel);
+        }
+
+        return true;
+    }
+
+    std::vector<int> parseList(const std::string &text) {
+        std::vector<int> values{};
+        std::istringstream stream(text);
+        std::string value;
+        while (std::getline(stream, value, ',')) {
+            values.push_back(std::stoi(value));
+        }
+        return values;
+    }
+
+    Options parseOptions(int argc, char **argv) {
+        Options options{};
+        for (int index = 1; index < argc; ++index) {
+            std::string arg = argv[index];
+            auto next = [&]() -> std::string {
+                if (argc <= index + 1) {
+                    throw std::runtime_error("Missing value of " + arg);
+                }
+                return argv[++index];
+            };
+
+            if (arg == "--game") {
+                options.game = next();
+            } else if (arg == "--threads") {
+                options.threads = parseList(next());
+            } else if (arg == "--repeat") {
+                options.repeat = std::stoi(next());
+            } else if (arg == "--timeout") {
+                options.timeout = static_cast<unsigned int>(std::stoul(next()));
+            } else if (arg == "--table") {
+                options.table = static_cast<unsigned int>(std::stoul(next()));
+            } else if (arg == "--verbose") {
+                options.verbose = true;
+            } else if (arg == "--check-growth") {
+                options.checkGrowth = true;
+            } else if (arg == "--collision") {
+                options.collision = true;
+            } else if (arg == "--generate") {
+                options.generate = std::stoi(next());
+            } else if (arg == "--seed") {
+                options.seed = static_cast<unsigned int>(std::stoul(next()));
+            } else if (!arg.empty() && arg[0] != '-') {
+                options.corpus = arg;
+            } else {
+                throw std::runtime_error("Unknown option: " + arg);
+            }
+        }
+        return options;
+    }
+}
+
+int main(int argc, char **argv) {
+    try {
+        auto options = parseOptions(argc, argv);
+
+        if (0 < options.generate) {
+            generate(options);
+            return 0;
+        }
+
+        if (options.collision) {
+            return benchmarkCollision() ? 0 : 1;
+        }
+
+        if (options.corpus.empty()) {
+            std::fprintf(stderr, "Usage: sfinder-bench [--game ppt|tetrio] [--threads 1,2,4] [--repeat N] "
+                                 "[--timeout MS] [--table MB] [--verbose] [--check-growth] <corpus>\n"
+                                 "       sfinder-bench --collision\n"
+                                 "       sfinder-bench --generate N [--seed S]\n");
+            return 2;
+        }
+
+        auto queries = loadCorpus(options.corpus);
+
+        bool warm;
+        if (options.game == "ppt") {
+            warm = run<PPTFinder>(options, core::Factory::create(), queries);
+        } else if (options.game == "tetrio") {
+            warm = run<TETRIOFinder>(options, core::Factory::createForSRSPlus(), queries);
+        } else {
+            throw std::runtime_error("Unknown game: " + options.game);
+        }
+
+        if (!warm) {
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,6 +2,7 @@
 #define CALLBACK_H
 
 typedef int(__stdcall * Callback)();
+typedef void(__stdcall * SolutionCallback)(const char* solution);
 
 extern Callback Abort;
 
@@ -1,5 +1,20 @@
 #include "bits.hpp"
 
+#include "cpu.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CORE_BITS_X64
+
+#include <immintrin.h>
+#endif
+
+// The function is compiled for BMI2 even if the rest is not, and only called when the CPU has it
+#if defined(CORE_BITS_X64) && !defined(__BMI2__) && (defined(__GNUC__) || defined(__clang__))
+#define CORE_TARGET_BMI2 __attribute__((target("bmi2")))
+#else
+#define CORE_TARGET_BMI2
+#endif
+
 namespace core {
     Bitboard deleteLine_(Bitboard x, LineKey key) {
         switch (key) {
@@ -137,10 +152,39 @@ namespace core {
         }
     }
 
+    namespace {
+        using DeleteLine = Bitboard (*)(Bitboard, LineKey);
+
+        Bitboard deleteLineBySwitch(Bitboard x, LineKey mask) {
+            // 1073741823 = (1 << 30) - 1
+            LineKey key = (mask >> 29) | (mask & 1073741823ULL);
+            return deleteLine_(x, key);
+        }
+
+#ifdef CORE_BITS_X64
+        // The rows to keep are gathered to the bottom at once
+        CORE_TARGET_BMI2
+        Bitboard deleteLineByPext(Bitboard x, LineKey mask) {
+            // `mask` has the lowest bit of each filled row
+            Bitboard filled = mask * 0x3ffULL;
+            return _pext_u64(x, ~filled & 0xfffffffffffffffULL);
+        }
+#endif
+
+        DeleteLine selectDeleteLine() {
+#ifdef CORE_BITS_X64
+            if (cpu::hasFastBmi2()) {
+                return deleteLineByPext;
+            }
+#endif
+            return deleteLineBySwitch;
+        }
+
+        const DeleteLine deleteLineKernel = selectDeleteLine();
+    }
+
     Bitboard deleteLine(Bitboard x, LineKey mask) {
-        // 1073741823 = (1 << 30) - 1
-        LineKey key = (mask >> 29) | (mask & 1073741823ULL);
-        return deleteLine_(x, key);
+        return deleteLineKernel(x, mask);
     }
 
     Bitboard insertBlackLine_(Bitboard x, LineKey key) {
@@ -451,33 +495,4 @@ namespace core {
         Bitboard leftHigh = reverseXBoardHigh & (columnHigh >> 1);
         return ((leftHigh << 1) & rightHigh) == 0L;
     }
-
-    int bitCount(uint64_t b) {
-        b -= (b >> 1) & 0x5555555555555555ULL;
-        b = ((b >> 2) & 0x3333333333333333ULL) + (b & 0x3333333333333333ULL);
-        b = ((b >> 4) + b) & 0x0F0F0F0F0F0F0F0FULL;
-        return static_cast<int>((b * 0x0101010101010101ULL) >> 56);
-    }
-
-    // 0b000000 => 0
-    // 0b000001 => 1
-    // 0b000010 => 2
-    // ...
-    // 0b100000 => 6
-    int mostSignificantDigit(uint64_t b) {
-        b |= b >> 1U;
-        b |= b >> 2U;
-        b |= b >> 4U;
-        b |= b >> 8U;
-        b |= b >> 16U;
-        b |= b >> 32U;
-        return bitCount(b);
-    }
-
-    uint64_t fillVertical(uint64_t b) {
-        b |= b >> 10U;
-        b |= b >> 10U;
-        b |= b >> 30U;
-        return b;
-    }
 }
\ No newline at end of file
@@ -5,6 +5,20 @@
 
 #include "types.hpp"
 
+// Every CPU with AVX2 also has POPCNT and LZCNT, so builds for AVX2 (as Release is) use them without checking the CPU
+#if defined(_MSC_VER) && defined(__AVX2__)
+#include <intrin.h>
+#define CORE_BITS_POPCNT
+#define CORE_BITS_LZCNT
+#elif defined(__GNUC__) || defined(__clang__)
+#ifdef __POPCNT__
+#define CORE_BITS_POPCNT
+#endif
+#ifdef __LZCNT__
+#define CORE_BITS_LZCNT
+#endif
+#endif
+
 namespace core {
     Bitboard deleteLine_(Bitboard x, LineKey key);
 
@@ -22,11 +36,46 @@ namespace core {
 
     bool isWallBetweenLeft(int x, int maxY, Bitboard board);
 
-    int bitCount(uint64_t b);
+    inline int bitCount(uint64_t b) {
+#if defined(CORE_BITS_POPCNT) && defined(_MSC_VER)
+        return static_cast<int>(__popcnt64(b));
+#elif defined(CORE_BITS_POPCNT)
+        return __builtin_popcountll(b);
+#else
+        b -= (b >> 1) & 0x5555555555555555ULL;
+        b = ((b >> 2) & 0x3333333333333333ULL) + (b & 0x3333333333333333ULL);
+        b = ((b >> 4) + b) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<int>((b * 0x0101010101010101ULL) >> 56);
+#endif
+    }
 
-    int mostSignificantDigit(uint64_t b);
+    // 0b000000 => 0
+    // 0b000001 => 1
+    // 0b000010 => 2
+    // ...
+    // 0b100000 => 6
+    inline int mostSignificantDigit(uint64_t b) {
+#if defined(CORE_BITS_LZCNT) && defined(_MSC_VER)
+        return 64 - static_cast<int>(__lzcnt64(b));
+#elif defined(CORE_BITS_LZCNT)
+        return b != 0 ? 64 - __builtin_clzll(b) : 0;
+#else
+        b |= b >> 1U;
+        b |= b >> 2U;
+        b |= b >> 4U;
+        b |= b >> 8U;
+        b |= b >> 16U;
+        b |= b >> 32U;
+        return bitCount(b);
+#endif
+    }
 
-    uint64_t fillVertical(uint64_t b);
+    inline uint64_t fillVertical(uint64_t b) {
+        b |= b >> 10U;
+        b |= b >> 10U;
+        b |= b >> 30U;
+        return b;
+    }
 }
 
 #endif //CORE_BITS_HPP
@@ -0,0 +1,86 @@
+#include "collision.hpp"
+
+#include <cassert>
+
+#include "cpu.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CORE_COLLISION_X64
+
+#include <immintrin.h>
+#endif
+
+// The function is compiled for AVX2 even if the rest is not, and only called when the CPU has it
+#if defined(CORE_COLLISION_X64) && !defined(__AVX2__) && (defined(__GNUC__) || defined(__clang__))
+#define CORE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CORE_TARGET_AVX2
+#endif
+
+namespace core::collision {
+    namespace {
+        using Kernel = void (*)(const uint32_t *, const Blocks &, int, uint32_t *);
+
+        uint32_t widthOf(const Blocks &blocks) {
+            return (1U << static_cast<unsigned>(FIELD_WIDTH - blocks.width + 1)) - 1U;
+        }
+
+        void scalarKernel(const uint32_t *rows, const Blocks &blocks, int numOfRows, uint32_t *free) {
+            uint32_t width = widthOf(blocks);
+
+            for (int lowerY = 0; lowerY < numOfRows; ++lowerY) {
+                uint32_t occupied = 0;
+                for (const auto &point : blocks.points) {
+                    occupied |= rows[lowerY + point.y - blocks.minY] >> static_cast<unsigned>(point.x - blocks.minX);
+                }
+                free[lowerY] = ~occupied & width;
+            }
+        }
+
+#ifdef CORE_COLLISION_X64
+        CORE_TARGET_AVX2
+        void avx2Kernel(const uint32_t *rows, const Blocks &blocks, int numOfRows, uint32_t *free) {
+            __m256i width = _mm256_set1_epi32(static_cast<int>(widthOf(blocks)));
+
+            for (int lowerY = 0; lowerY < numOfRows; lowerY += 8) {
+                __m256i occupied = _mm256_setzero_si256();
+                for (const auto &point : blocks.points) {
+                    auto row = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows + lowerY + point.y - blocks.minY));
+                    auto count = _mm_cvtsi32_si128(point.x - blocks.minX);
+                    occupied = _mm256_or_si256(occupied, _mm256_srl_epi32(row, count));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(free + lowerY), _mm256_andnot_si256(occupied, width));
+            }
+        }
+#endif
+
+        Kernel selectKernel() {
+#ifdef CORE_COLLISION_X64
+            if (cpu::hasAvx2()) {
+                return avx2Kernel;
+            }
+#endif
+            return scalarKernel;
+        }
+
+        const Kernel kernel = selectKernel();
+
+        static_assert(MAX_FIELD_HEIGHT % 8 == 0, "The AVX2 kernel writes 8 rows at once");
+    }
+
+    void getFreeRows(const uint32_t (&rows)[kPaddedHeight], const Blocks &blocks, int numOfRows,
+                     uint32_t (&free)[MAX_FIELD_HEIGHT]) {
+        assert(0 <= numOfRows && numOfRows <= MAX_FIELD_HEIGHT);
+        kernel(rows, blocks, numOfRows, free);
+    }
+
+    void getFreeRowsScalar(const uint32_t (&rows)[kPaddedHeight], const Blocks &blocks, int numOfRows,
+                           uint32_t (&free)[MAX_FIELD_HEIGHT]) {
+        assert(0 <= numOfRows && numOfRows <= MAX_FIELD_HEIGHT);
+        scalarKernel(rows, blocks, numOfRows, free);
+    }
+
+    bool usesAvx2() {
+        return kernel != scalarKernel;
+    }
+}
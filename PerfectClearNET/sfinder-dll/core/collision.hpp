@@ -0,0 +1,27 @@
+#ifndef CORE_COLLISION_HPP
+#define CORE_COLLISION_HPP
+
+#include <cstdint>
+
+#include "piece.hpp"
+
+namespace core::collision {
+    // Rows of a field as 10-bit masks, followed by empty rows for the blocks sticking out of the top
+    constexpr int kPaddedHeight = MAX_FIELD_HEIGHT + 4;
+
+    // Writes the mask indices (bit `x` is the left edge) where `blocks` fits, for every lower y in [0, numOfRows).
+    // It is the same as `Field::canPutAtMaskIndex` over all x at once, and over 8 rows at once with AVX2.
+    // `free` may be overwritten up to the next multiple of 8 rows, so it must have `MAX_FIELD_HEIGHT` rows.
+    void getFreeRows(const uint32_t (&rows)[kPaddedHeight], const Blocks &blocks, int numOfRows,
+                     uint32_t (&free)[MAX_FIELD_HEIGHT]);
+
+    // Same as `getFreeRows` with the portable kernel, one row at a time. It is used when the CPU does not have AVX2,
+    // and by sfinder-bench to check and time the AVX2 kernel against it.
+    void getFreeRowsScalar(const uint32_t (&rows)[kPaddedHeight], const Blocks &blocks, int numOfRows,
+                           uint32_t (&free)[MAX_FIELD_HEIGHT]);
+
+    // Whether `getFreeRows` runs the AVX2 kernel
+    bool usesAvx2();
+}
+
+#endif //CORE_COLLISION_HPP
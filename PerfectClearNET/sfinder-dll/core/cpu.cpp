@@ -0,0 +1,111 @@
+#include "cpu.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CORE_CPU_X64
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace core::cpu {
+#ifdef CORE_CPU_X64
+    namespace {
+        struct Registers {
+            unsigned int eax;
+            unsigned int ebx;
+            unsigned int ecx;
+            unsigned int edx;
+        };
+
+        Registers cpuid(unsigned int leaf, unsigned int subleaf) {
+            Registers registers{};
+#ifdef _MSC_VER
+            int info[4];
+            __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+            registers = {
+                    static_cast<unsigned int>(info[0]), static_cast<unsigned int>(info[1]),
+                    static_cast<unsigned int>(info[2]), static_cast<unsigned int>(info[3]),
+            };
+#else
+            __cpuid_count(leaf, subleaf, registers.eax, registers.ebx, registers.ecx, registers.edx);
+#endif
+            return registers;
+        }
+
+#ifndef __AVX2__
+        // The OS must save the YMM registers too
+        bool osSavesYmm() {
+            if ((cpuid(1, 0).ecx & (1U << 27U)) == 0) {
+                return false;
+            }
+
+#ifdef _MSC_VER
+            auto xcr0 = _xgetbv(0);
+#else
+            unsigned int low;
+            unsigned int high;
+            __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+            auto xcr0 = (static_cast<unsigned long long>(high) << 32U) | low;
+#endif
+            return (xcr0 & 6U) == 6U;
+        }
+
+        bool detectAvx2() {
+            if (cpuid(0, 0).eax < 7) {
+                return false;
+            }
+
+            bool avx = (cpuid(1, 0).ecx & (1U << 28U)) != 0;
+            bool avx2 = (cpuid(7, 0).ebx & (1U << 5U)) != 0;
+            return avx && avx2 && osSavesYmm();
+        }
+#endif
+
+        bool detectFastBmi2() {
+            auto vendor = cpuid(0, 0);
+            if (vendor.eax < 7 || (cpuid(7, 0).ebx & (1U << 8U)) == 0) {
+                return false;
+            }
+
+            // "AuthenticAMD"
+            bool amd = vendor.ebx == 0x68747541U && vendor.edx == 0x69746e65U && vendor.ecx == 0x444d4163U;
+            if (!amd) {
+                return true;
+            }
+
+            auto signature = cpuid(1, 0).eax;
+            auto family = (signature >> 8U) & 0xfU;
+            if (family == 0xfU) {
+                family += (signature >> 20U) & 0xffU;
+            }
+            return 0x19U <= family;
+        }
+    }
+
+    bool hasAvx2() {
+#ifdef __AVX2__
+        return true;
+#else
+        // Detected on the first call, since it is called while other static objects are initialized
+        static const bool avx2 = detectAvx2();
+        return avx2;
+#endif
+    }
+
+    bool hasFastBmi2() {
+        static const bool fastBmi2 = detectFastBmi2();
+        return fastBmi2;
+    }
+#else
+    bool hasAvx2() {
+        return false;
+    }
+
+    bool hasFastBmi2() {
+        return false;
+    }
+#endif
+}
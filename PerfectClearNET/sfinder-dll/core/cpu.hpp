@@ -0,0 +1,13 @@
+#ifndef CORE_CPU_HPP
+#define CORE_CPU_HPP
+
+namespace core::cpu {
+    // Whether the CPU and the OS support AVX2. Always true when the build targets AVX2
+    bool hasAvx2();
+
+    // Whether the CPU has BMI2 with PEXT/PDEP in hardware.
+    // AMD CPUs before Zen 3 run them in microcode, taking hundreds of cycles, so they are treated as not having it.
+    bool hasFastBmi2();
+}
+
+#endif //CORE_CPU_HPP
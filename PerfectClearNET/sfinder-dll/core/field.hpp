@@ -2,6 +2,7 @@
 #define CORE_FIELD_HPP
 
 #include <cassert>
+#include <string>
 
 #include "types.hpp"
 #include "bits.hpp"
@@ -0,0 +1,422 @@
+#ifndef CORE_FLOOD_MOVES_HPP
+#define CORE_FLOOD_MOVES_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "collision.hpp"
+#include "field.hpp"
+#include "moves.hpp"
+
+namespace core::srs_flood {
+    // Same results as `srs::MoveGenerator`, but the reachable positions of each rotation are computed at once.
+    // Every row is a bitboard whose bit `x` is the left edge (mask index) of the piece.
+    //
+    // `reach`: the piece can be at the position while falling (it came from the top, by harddrop or by softdrop)
+    // `stand`: the piece can be moved left/right or rotated from the position
+    // When AllowSoftdropTap is true, both are the same.
+    // When AllowSoftdropTap is false, a falling piece can be moved only after it reaches the ground.
+    //
+    // `rotated`: the piece can be at the position right after a rotation (the last move of a spin).
+    // Kicks into the filled rows from `limit` are not recorded, but no move is there.
+    template<bool Allow180 = false, bool AllowSoftdropTap = true>
+    class MoveGenerator {
+    public:
+        explicit MoveGenerator(const Factory &factory)
+                : factory(factory), height(0), lastField(), lastPieceType(PieceType::Empty), lastAppearY(-1) {
+        }
+
+        void search(std::vector<Move> &moves, const Field &field, PieceType pieceType, int validHeight) {
+            flood(field, pieceType, validHeight);
+
+            auto &piece = factory.get(pieceType);
+
+            uint32_t pushed[4][FIELD_WIDTH]{};
+
+            for (int rotate = 0; rotate < 4; ++rotate) {
+                auto rotateType = static_cast<RotateType>(rotate);
+                auto &blocks = factory.get(pieceType, rotateType);
+                auto &board = boards[rotate];
+
+                int maxLowerY = validHeight - blocks.height;
+                if (MAX_FIELD_HEIGHT <= maxLowerY) {
+                    maxLowerY = MAX_FIELD_HEIGHT - 1;
+                }
+
+                uint32_t goals[MAX_FIELD_HEIGHT];
+                uint32_t any = 0;
+                for (int lowerY = 0; lowerY <= maxLowerY; ++lowerY) {
+                    goals[lowerY] = board.stand[lowerY] & board.ground[lowerY];
+                    any |= goals[lowerY];
+                }
+
+                if (any == 0) {
+                    continue;
+                }
+
+                // Keep the order of `srs::MoveGenerator` (x ascending, y descending)
+                auto &transform = piece.transforms[rotateType];
+                for (int leftX = 0, maxLeftX = FIELD_WIDTH - blocks.width; leftX <= maxLeftX; ++leftX) {
+                    if ((any >> static_cast<unsigned>(leftX) & 1U) == 0) {
+                        continue;
+                    }
+
+                    for (int lowerY = maxLowerY; 0 <= lowerY; --lowerY) {
+                        if ((goals[lowerY] >> static_cast<unsigned>(leftX) & 1U) == 0) {
+                            continue;
+                        }
+
+                        int x = leftX - blocks.minX;
+                        int y = lowerY - blocks.minY;
+
+                        RotateType newRotate = transform.toRotate;
+                        int newX = x + transform.offset.x;
+                        int newY = y + transform.offset.y;
+
+                        uint32_t mask = 1U << static_cast<unsigned>(newY);
+                        if ((pushed[newRotate][newX] & mask) == 0) {
+                            pushed[newRotate][newX] |= mask;
+                            bool harddrop = (board.harddrop[lowerY] >> static_cast<unsigned>(leftX) & 1U) != 0;
+                            moves.push_back(Move{newRotate, newX, newY, harddrop, getRotation(piece, newRotate, newX, newY)});
+                        }
+                    }
+                }
+            }
+        }
+
+        bool canReach(const Field &field, PieceType pieceType, RotateType rotateType, int x, int y,
+                      int validHeight) {
+            assert(field.canPut(factory.get(pieceType, rotateType), x, y));
+
+            flood(field, pieceType, validHeight);
+
+            auto &piece = factory.get(pieceType);
+
+            auto &transform = piece.transforms[rotateType];
+            auto currentRotateType = transform.toRotate;
+            auto currentX = x + transform.offset.x;
+            auto currentY = y + transform.offset.y;
+
+            auto bit = static_cast<unsigned>(piece.sameShapeRotates[currentRotateType]);
+            assert(bit != 0);
+
+            do {
+                auto next = bit & (bit - 1U);
+                RotateType nextRotateType = rotateBitToVal[bit & ~next];
+
+                auto &blocks = factory.get(pieceType, nextRotateType);
+
+                auto &nextTransform = piece.transforms[nextRotateType];
+
+                assert(currentRotateType == nextTransform.toRotate);
+
+                int leftX = currentX - nextTransform.offset.x + blocks.minX;
+                int lowerY = currentY - nextTransform.offset.y + blocks.minY;
+                assert(lowerY < height);
+
+                if ((boards[nextRotateType].stand[lowerY] >> static_cast<unsigned>(leftX) & 1U) != 0) {
+                    return true;
+                }
+
+                bit = next;
+            } while (bit != 0);
+
+            return false;
+        }
+
+    private:
+        struct RotateBoard {
+            uint32_t free[MAX_FIELD_HEIGHT];
+            uint32_t ground[MAX_FIELD_HEIGHT];
+            uint32_t harddrop[MAX_FIELD_HEIGHT];
+            uint32_t reach[MAX_FIELD_HEIGHT];
+            uint32_t stand[MAX_FIELD_HEIGHT];
+            uint32_t kicked[MAX_FIELD_HEIGHT];
+            uint32_t rotated[MAX_FIELD_HEIGHT];
+
+            // The rows from `limit` never change.
+            // When AllowSoftdropTap is false, `limit` grows when a piece is kicked into there.
+            int limit;
+        };
+
+        const Factory &factory;
+
+        RotateBoard boards[4];
+
+        // Only the rows under `height` are computed.
+        // No position above the top or the field can kick more than `MarginHeight` rows down into them.
+        static constexpr int MarginHeight = 4;
+        int height;
+
+        Field lastField;
+        PieceType lastPieceType;
+        int lastAppearY;
+
+        // Any of the same shapes at the position may be rotated into.
+        // Without softdrop taps, `srs_rotate_end::Reachable` rejects some kicks into the air that the flood accepts,
+        // so it is left to that.
+        Rotation getRotation(const Piece &piece, RotateType rotateType, int x, int y) const {
+            if constexpr (!AllowSoftdropTap) {
+                return Rotation::Unknown;
+            }
+
+            auto bit = static_cast<unsigned>(piece.sameShapeRotates[rotateType]);
+            assert(bit != 0);
+
+            do {
+                auto next = bit & (bit - 1U);
+                RotateType nextRotateType = rotateBitToVal[bit & ~next];
+
+                auto &blocks = piece.blocks[nextRotateType];
+                auto &nextTransform = piece.transforms[nextRotateType];
+
+                int leftX = x - nextTransform.offset.x + blocks.minX;
+                int lowerY = y - nextTransform.offset.y + blocks.minY;
+
+                if ((boards[nextRotateType].rotated[lowerY] >> static_cast<unsigned>(leftX) & 1U) != 0) {
+                    return Rotation::Yes;
+                }
+
+                bit = next;
+            } while (bit != 0);
+
+            return Rotation::No;
+        }
+
+        static uint32_t getRow(const Field &field, int y) {
+            if (MAX_FIELD_HEIGHT <= y) {
+                return 0;
+            }
+
+            int index = y / 6;
+            return static_cast<uint32_t>(field.boards[index] >> static_cast<unsigned>((y - 6 * index) * FIELD_WIDTH)) & 0x3ffU;
+        }
+
+        static uint32_t shift(uint32_t row, int dx) {
+            return 0 <= dx ? row << static_cast<unsigned>(dx) : row >> static_cast<unsigned>(-dx);
+        }
+
+        // Fill `row` to left and right within the runs of `free`
+        static uint32_t spread(uint32_t row, uint32_t free) {
+            uint32_t left = free;
+            uint32_t right = free;
+            for (unsigned step = 1; step < FIELD_WIDTH; step <<= 1U) {
+                row |= (left & row << step) | (right & row >> step);
+                left &= left << step;
+                right &= right >> step;
+            }
+            return row;
+        }
+
+        void flood(const Field &field, PieceType pieceType, int appearY) {
+            if (pieceType == lastPieceType && appearY == lastAppearY && field == lastField) {
+                return;
+            }
+
+            lastField = field;
+            lastPieceType = pieceType;
+            lastAppearY = appearY;
+
+            // The rows from `fieldTop` are empty
+            uint32_t rows[collision::kPaddedHeight]{};
+            int fieldTop = 0;
+            for (int y = 0; y < MAX_FIELD_HEIGHT; ++y) {
+                rows[y] = getRow(field, y);
+                if (rows[y] != 0) {
+                    fieldTop = y + 1;
+                }
+            }
+
+            height = std::min(std::max(appearY, fieldTop) + MarginHeight, MAX_FIELD_HEIGHT);
+
+            for (int rotate = 0; rotate < 4; ++rotate) {
+                auto &blocks = factory.get(pieceType, static_cast<RotateType>(rotate));
+                auto &board = boards[rotate];
+
+                uint32_t width = (1U << static_cast<unsigned>(FIELD_WIDTH - blocks.width + 1)) - 1U;
+                collision::getFreeRows(rows, blocks, fieldTop, board.free);
+                for (int lowerY = fieldTop; lowerY < height; ++lowerY) {
+                    board.free[lowerY] = width;
+                }
+
+                // Same as `Field::isOnGround`
+                board.ground[0] = board.free[0];
+                for (int lowerY = 1; lowerY < height; ++lowerY) {
+                    board.ground[lowerY] = lowerY <= fieldTop ? board.free[lowerY] & ~board.free[lowerY - 1] : 0;
+                }
+
+                // Same as `Field::canReachOnHarddrop`. The positions sticking out of the field are always reachable.
+                int top = std::min(MAX_FIELD_HEIGHT - blocks.height, fieldTop);
+                for (int lowerY = height - 1; top <= lowerY; --lowerY) {
+                    board.harddrop[lowerY] = board.free[lowerY];
+                }
+                for (int lowerY = top - 1; 0 <= lowerY; --lowerY) {
+                    board.harddrop[lowerY] = board.free[lowerY] & board.harddrop[lowerY + 1];
+                }
+
+                // Reachable from the top.
+                // When AllowSoftdropTap is true, the rows from `appearY` are filled at once because every position in them is a goal.
+                // When AllowSoftdropTap is false, the pieces in the empty rows can't stand until they are kicked into.
+                int appearLowerY = appearY + blocks.minY;
+                if constexpr (AllowSoftdropTap) {
+                    board.limit = std::clamp(appearLowerY, 0, height);
+                } else {
+                    board.limit = std::clamp(std::max(appearLowerY, fieldTop + 1), 0, height);
+                }
+                for (int lowerY = 0; lowerY < height; ++lowerY) {
+                    board.reach[lowerY] = appearLowerY <= lowerY ? board.free[lowerY] : board.harddrop[lowerY];
+                    board.stand[lowerY] = AllowSoftdropTap && board.limit <= lowerY ? board.free[lowerY] : 0;
+                    board.kicked[lowerY] = 0;
+                    board.rotated[lowerY] = 0;
+                }
+
+                settle(board, appearLowerY, height);
+            }
+
+            auto &piece = factory.get(pieceType);
+
+            // Rotate only the positions that have not been rotated yet, until nothing changes
+            while (true) {
+                uint32_t deltas[4][MAX_FIELD_HEIGHT];
+                bool any = false;
+                for (int rotate = 0; rotate < 4; ++rotate) {
+                    auto &board = boards[rotate];
+                    for (int lowerY = 0, maxLowerY = AllowSoftdropTap ? height : board.limit; lowerY < maxLowerY; ++lowerY) {
+                        deltas[rotate][lowerY] = board.stand[lowerY] & ~board.kicked[lowerY];
+                        board.kicked[lowerY] = board.stand[lowerY];
+                        any |= deltas[rotate][lowerY] != 0;
+                    }
+                }
+
+                if (!any) {
+                    break;
+                }
+
+                bool updated[4] = {false, false, false, false};
+                for (int rotate = 0; rotate < 4; ++rotate) {
+                    auto fromRotate = static_cast<RotateType>(rotate);
+                    auto &delta = deltas[rotate];
+
+                    auto rightRotate = (rotate + 1) % 4;
+                    updated[rightRotate] |= kick(
+                            piece, delta, fromRotate, static_cast<RotateType>(rightRotate),
+                            &piece.rightOffsets[rotate * Piece::MaxOffsetRotate90], piece.offsetsSize
+                    );
+
+                    auto leftRotate = (rotate + 3) % 4;
+                    updated[leftRotate] |= kick(
+                            piece, delta, fromRotate, static_cast<RotateType>(leftRotate),
+                            &piece.leftOffsets[rotate * Piece::MaxOffsetRotate90], piece.offsetsSize
+                    );
+
+                    if constexpr (Allow180) {
+                        auto reverseRotate = (rotate + 2) % 4;
+                        updated[reverseRotate] |= kick(
+                                piece, delta, fromRotate, static_cast<RotateType>(reverseRotate),
+                                &piece.rotate180Offsets[rotate * Piece::MaxOffsetRotate180], piece.rotate180OffsetsSize
+                        );
+                    }
+                }
+
+                for (int rotate = 0; rotate < 4; ++rotate) {
+                    if (updated[rotate]) {
+                        auto &blocks = factory.get(pieceType, static_cast<RotateType>(rotate));
+                        settle(boards[rotate], appearY + blocks.minY, height);
+                    }
+                }
+            }
+        }
+
+        // Spread `stand` to left/right and drop it, until nothing changes in the rotation
+        static void settle(RotateBoard &board, int appearLowerY, int height) {
+            for (int lowerY = board.limit - 1; 0 <= lowerY; --lowerY) {
+                uint32_t reach = board.reach[lowerY] | board.stand[lowerY];
+
+                // A piece can move down only under the top
+                if (lowerY + 1 < height && lowerY + 1 < appearLowerY) {
+                    reach |= board.reach[lowerY + 1] & board.free[lowerY];
+                }
+
+                uint32_t stand = AllowSoftdropTap ? board.stand[lowerY] | reach : board.stand[lowerY] | (reach & board.ground[lowerY]);
+                if (stand != 0) {
+                    stand = spread(stand, board.free[lowerY]);
+                }
+
+                board.reach[lowerY] = reach | stand;
+                board.stand[lowerY] = stand;
+            }
+        }
+
+        // Apply the first kick that succeeds to every position of `delta`. Returns true if `stand` of `toRotate` grows.
+        bool kick(
+                const Piece &piece, const uint32_t (&delta)[MAX_FIELD_HEIGHT], RotateType fromRotate, RotateType toRotate,
+                const Offset *offsets, int size
+        ) {
+            if (size == 0) {
+                return false;
+            }
+
+            auto &fromBlocks = piece.blocks[fromRotate];
+            auto &toBlocks = piece.blocks[toRotate];
+            auto &to = boards[toRotate];
+
+            // When AllowSoftdropTap is true, the positions whose kicks all end in the filled rows don't change anything
+            int maxLowerY = boards[fromRotate].limit;
+            if constexpr (AllowSoftdropTap) {
+                int minDy = MAX_FIELD_HEIGHT;
+                for (int index = 0; index < size; ++index) {
+                    minDy = std::min(minDy, offsets[index].y);
+                }
+                minDy += toBlocks.minY - fromBlocks.minY;
+                maxLowerY = std::min(to.limit - minDy, height);
+            }
+
+            // Only the rows in [minLowerY, maxLowerY) have positions
+            uint32_t rest[MAX_FIELD_HEIGHT];
+            int minLowerY = maxLowerY;
+            for (int lowerY = maxLowerY - 1; 0 <= lowerY; --lowerY) {
+                rest[lowerY] = delta[lowerY];
+                if (rest[lowerY] != 0) {
+                    minLowerY = lowerY;
+                }
+            }
+            while (minLowerY < maxLowerY && rest[maxLowerY - 1] == 0) {
+                maxLowerY -= 1;
+            }
+
+            bool updated = false;
+            for (int index = 0; index < size && minLowerY < maxLowerY; ++index) {
+                auto &offset = offsets[index];
+                int dx = toBlocks.minX - fromBlocks.minX + offset.x;
+                int dy = toBlocks.minY - fromBlocks.minY + offset.y;
+
+                int startY = std::max(minLowerY, -dy);
+                int endY = std::min(maxLowerY, height - dy);
+                for (int lowerY = startY; lowerY < endY; ++lowerY) {
+                    if (rest[lowerY] == 0) {
+                        continue;
+                    }
+
+                    int toY = lowerY + dy;
+                    uint32_t hit = shift(rest[lowerY], dx) & to.free[toY];
+                    if (hit == 0) {
+                        continue;
+                    }
+
+                    rest[lowerY] &= ~shift(hit, -dx);
+                    to.rotated[toY] |= hit;
+
+                    if ((hit & ~to.stand[toY]) != 0) {
+                        to.stand[toY] |= hit;
+                        to.limit = std::max(to.limit, toY + 1);
+                        updated = true;
+                    }
+                }
+            }
+
+            return updated;
+        }
+    };
+}
+
+#endif //CORE_FLOOD_MOVES_HPP
@@ -7,11 +7,21 @@
 #include "srs.hpp"
 
 namespace core {
+    enum class Rotation : uint8_t {
+        Unknown = 0,
+        No = 1,
+        Yes = 2,
+    };
+
     struct Move {
         RotateType rotateType;
         int x;
         int y;
         bool harddrop;
+
+        // Whether a rotation can be the last move into the position, as `srs_rotate_end::Reachable` checks.
+        // Filled only by the move generators that get it for free.
+        Rotation rotation;
     };
 
     struct ScoredMove {
@@ -1,7 +1,8 @@
 #ifndef CORE_PIECE_HPP
 #define CORE_PIECE_HPP
 
-#include <string>
+#include <cassert>
+#include <string_view>
 #include <algorithm>
 #include <array>
 
@@ -20,11 +21,11 @@ namespace core {
         int y;
     };
 
-    inline Offset operator+(const Offset &lhs, const Offset &rhs) {
+    constexpr Offset operator+(const Offset &lhs, const Offset &rhs) {
         return {lhs.x + rhs.x, lhs.y + rhs.y};
     }
 
-    inline Offset operator-(const Offset &lhs, const Offset &rhs) {
+    constexpr Offset operator-(const Offset &lhs, const Offset &rhs) {
         return {lhs.x - rhs.x, lhs.y - rhs.y};
     }
 
@@ -44,7 +45,7 @@ namespace core {
 
     class Blocks {
     public:
-        static Blocks create(RotateType rotateType, const std::array<Point, 4> &points);
+        static constexpr Blocks create(RotateType rotateType, const std::array<Point, 4> &points);
 
         const RotateType rotateType;
         const std::array<Point, 4> points;
@@ -56,14 +57,51 @@ namespace core {
         const int width;
         const int height;
 
-        BlocksMask mask(int leftX, int lowerY) const;
+        constexpr BlocksMask mask(int leftX, int lowerY) const {
+            assert(0 <= leftX && leftX <= FIELD_WIDTH - width);
+            assert(0 <= lowerY && lowerY < 6);
+
+            if (6 < lowerY + height) {
+                // Over
+                const auto slide = mask_ << leftX;
+                return {
+                        (slide << (lowerY * FIELD_WIDTH)) & VALID_BOARD_RANGE, slide >> ((6 - lowerY) * FIELD_WIDTH)
+                };
+            } else {
+                // Fit in the lower 6
+                return {
+                        mask_ << (lowerY * FIELD_WIDTH + leftX), 0
+                };
+            }
+        }
+
+        // Same as `mask(leftX, lowerY).low` when the blocks fit in the lower 6 rows
+        constexpr Bitboard lowMask(int leftX, int lowerY) const {
+            assert(0 <= leftX && leftX <= FIELD_WIDTH - width);
+            assert(0 <= lowerY && lowerY + height <= 6);
+
+            return mask_ << (lowerY * FIELD_WIDTH + leftX);
+        }
 
-        Collider harddrop(int leftX, int lowerY) const;
+        constexpr Collider harddrop(int leftX, int lowerY) const {
+            assert(0 <= leftX && leftX <= FIELD_WIDTH - width);
+            assert(0 <= lowerY && lowerY < MAX_FIELD_HEIGHT);
+
+            auto &collider = harddropColliders[lowerY];
+            return Collider{
+                    collider.boards[0] << leftX,
+                    collider.boards[1] << leftX,
+                    collider.boards[2] << leftX,
+                    collider.boards[3] << leftX,
+            };
+        }
 
     private:
-        Blocks(const RotateType rotateType, const std::array<Point, 4> points, const Bitboard mask,
-               const std::array<Collider, MAX_FIELD_HEIGHT> harddropColliders,
-               const MinMax &minMaxX, const MinMax &minMaxY)
+        static constexpr Bitboard VALID_BOARD_RANGE = 0xfffffffffffffffL;
+
+        constexpr Blocks(const RotateType rotateType, const std::array<Point, 4> points, const Bitboard mask,
+                         const std::array<Collider, MAX_FIELD_HEIGHT> harddropColliders,
+                         const MinMax &minMaxX, const MinMax &minMaxY)
                 : rotateType(rotateType), points(points), harddropColliders(harddropColliders),
                   minX(minMaxX.first), maxX(minMaxX.second), minY(minMaxY.first), maxY(minMaxY.second),
                   width(minMaxX.second - minMaxX.first + 1), height(minMaxY.second - minMaxY.first + 1), mask_(mask) {
@@ -78,18 +116,18 @@ namespace core {
         static constexpr int MaxOffsetRotate180 = 6;
 
         template<size_t OffsetSizeRotate90>
-        static Piece create(
+        static constexpr Piece create(
                 PieceType pieceType,
-                const std::string &name,
+                std::string_view name,
                 const std::array<Point, 4> &points,
                 const std::array<std::array<Offset, OffsetSizeRotate90>, 4> &offsets,
                 const std::array<Transform, 4> &transforms
         );
 
         template<size_t OffsetSizeRotate90, size_t OffsetSizeRotate180>
-        static Piece create(
+        static constexpr Piece create(
                 PieceType pieceType,
-                const std::string &name,
+                std::string_view name,
                 const std::array<Point, 4> &points,
                 const std::array<std::array<Offset, OffsetSizeRotate90>, 4> &offsets,
                 const std::array<Offset, 24> &rotate180Offsets,
@@ -97,9 +135,9 @@ namespace core {
         );
 
         template <size_t OffsetSizeRotate90, size_t OffsetSizeRotate180>
-        static Piece create(
+        static constexpr Piece create(
             PieceType pieceType,
-            const std::string &name,
+            std::string_view name,
             const std::array<Point, 4> &points,
             const std::array<Offset, MaxOffsetRotate90 * 4> &cwOffsets,
             const std::array<Offset, MaxOffsetRotate90 * 4> &ccwOffsets,
@@ -108,7 +146,7 @@ namespace core {
         );
 
         const PieceType pieceType;
-        const std::string name;
+        const std::string_view name;
         const std::array<Blocks, 4> blocks;
         const std::array<Offset, MaxOffsetRotate90 * 4> rightOffsets; // = cwOffsets
         const std::array<Offset, MaxOffsetRotate90 * 4> leftOffsets; // = ccwOffsets
@@ -120,9 +158,9 @@ namespace core {
         const std::array<int32_t, 4> sameShapeRotates;
 
     private:
-        Piece(
+        constexpr Piece(
                 const PieceType pieceType,
-                const std::string name,
+                const std::string_view name,
                 const std::array<Blocks, 4> blocks,
                 const std::array<Offset, 20> cwOffsets,
                 const std::array<Offset, 20> ccwOffsets,
@@ -142,11 +180,12 @@ namespace core {
 
     class Factory {
     public:
-        static Factory create();
+        // The tables of SRS and SRS+ are built at compile time. These return them without building anything
+        static const Factory &create();
 
-        static Factory createForSRSPlus();
+        static const Factory &createForSRSPlus();
 
-        static Factory create(
+        static constexpr Factory create(
             const Piece& t,
             const Piece& i,
             const Piece& l,
@@ -156,16 +195,21 @@ namespace core {
             const Piece& o
         );
 
-        const Piece &get(PieceType piece) const;
+        constexpr const Piece &get(PieceType piece) const {
+            assert(0 <= piece && static_cast<size_t>(piece) < pieces.size());
+            return pieces[piece];
+        }
 
-        const Blocks &get(PieceType piece, RotateType rotate) const;
+        constexpr const Blocks &get(PieceType piece, RotateType rotate) const {
+            assert(0 <= piece && static_cast<size_t>(piece) < pieces.size());
+            return pieces[piece].blocks[rotate];
+        }
 
     private:
-        Factory(const std::array<Piece, 7> &pieces, const std::array<Blocks, 28> &blocks) : pieces(pieces), blocks(blocks) {
+        constexpr explicit Factory(const std::array<Piece, 7> &pieces) : pieces(pieces) {
         };
 
         const std::array<Piece, 7> pieces;
-        const std::array<Blocks, 28> blocks;
     };
 }
 
@@ -0,0 +1,88 @@
+#ifndef CORE_SMALL_FIELD_HPP
+#define CORE_SMALL_FIELD_HPP
+
+#include <cassert>
+
+#include "types.hpp"
+#include "bits.hpp"
+#include "field.hpp"
+#include "piece.hpp"
+
+namespace core::small_field {
+    // Operations on fields whose blocks are all in the lower 6 rows, i.e. that fit in `xBoardLow` alone.
+    // While 6 lines or fewer are left to clear, no block is placed above them, so the fields of the search stay small.
+    // Each gives the same result as the `Field` method of the same name, without touching the other boards or branching on them.
+    constexpr int MAX_HEIGHT = 6;
+
+    namespace detail {
+        inline constexpr Bitboard ROW = 0x3ffULL;
+        inline constexpr Bitboard LEFT_COLUMN = 0x0004010040100401ULL;
+
+        inline constexpr Bitboard rowsBelow(int maxY) {
+            assert(0 <= maxY && maxY <= MAX_HEIGHT);
+            return (1ULL << static_cast<unsigned>(maxY * FIELD_WIDTH)) - 1ULL;
+        }
+    }
+
+    inline bool isSmall(const Field &field) {
+        return (field.xBoardMidLow | field.xBoardMidHigh | field.xBoardHigh) == 0;
+    }
+
+    inline void put(Field &field, const Blocks &blocks, int x, int y) {
+        assert(isSmall(field));
+        field.xBoardLow |= blocks.lowMask(x + blocks.minX, y + blocks.minY);
+    }
+
+    // Lowers the remaining rows over the filled ones, one row at a time without branches
+    inline int clearLineReturnNum(Field &field) {
+        assert(isSmall(field));
+
+        Bitboard board = field.xBoardLow;
+        Bitboard cleared = 0;
+        unsigned shift = 0;
+
+        for (int y = 0; y < MAX_HEIGHT; ++y) {
+            Bitboard row = board >> static_cast<unsigned>(y * FIELD_WIDTH) & detail::ROW;
+            Bitboard keep = row != detail::ROW;
+            cleared |= (row & (0ULL - keep)) << shift;
+            shift += static_cast<unsigned>(keep) * FIELD_WIDTH;
+        }
+
+        field.xBoardLow = cleared;
+        return MAX_HEIGHT - static_cast<int>(shift / FIELD_WIDTH);
+    }
+
+    inline int getNumOfHoles(const Field &field) {
+        assert(isSmall(field));
+        return bitCount(fillVertical(field.xBoardLow) & ~field.xBoardLow);
+    }
+
+    // Whether every region split by vertical walls below `maxLine` has a multiple of 4 empty cells.
+    // Columns are merged until the next wall, and each region is counted at once.
+    inline bool validate(const Field &field, int maxLine) {
+        assert(0 < maxLine && maxLine <= MAX_HEIGHT);
+
+        Bitboard empty = ~field.xBoardLow & detail::rowsBelow(maxLine);
+
+        // Bit x is set where the column x and its right column are both empty in some row
+        Bitboard pairs = empty & empty >> 1U;
+        pairs |= pairs >> 30U;
+        pairs |= pairs >> 10U | pairs >> 20U;
+        Bitboard connected = pairs & detail::ROW;
+
+        Bitboard region = detail::LEFT_COLUMN;
+        for (int x = 1; x < FIELD_WIDTH; ++x) {
+            if ((connected >> static_cast<unsigned>(x - 1) & 1U) == 0) {
+                if (bitCount(empty & region) % 4 != 0) {
+                    return false;
+                }
+                region = 0;
+            }
+            region |= detail::LEFT_COLUMN << static_cast<unsigned>(x);
+        }
+
+        return bitCount(empty & region) % 4 == 0;
+    }
+}
+
+#endif //CORE_SMALL_FIELD_HPP
@@ -0,0 +1,71 @@
+#ifndef FINDER_CANCELLATION_HPP
+#define FINDER_CANCELLATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace finder {
+    // Tells running searches to stop. Reading it is a single atomic load, so the search can check it at every node.
+    // The deadline is an absolute time of std::chrono::steady_clock in nanoseconds. 0 means no deadline.
+    // It is only compared when `poll` is called, since reading the clock is not free.
+    // A token made from a parent is also cancelled when the parent is, but cancelling it leaves the parent running.
+    class CancellationToken {
+    public:
+        explicit CancellationToken(CancellationToken *parent = nullptr) : parent_(parent) {
+        }
+
+        static int64_t now() {
+            auto time = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+        }
+
+        // Clears the cancel. When other threads may cancel, call it where they cannot cancel the previous search anymore
+        void reset(int64_t deadline) {
+            deadline_.store(deadline, std::memory_order_relaxed);
+            cancelled_.store(false, std::memory_order_release);
+        }
+
+        // Leaves a pending cancel in place
+        void setDeadline(int64_t deadline) {
+            deadline_.store(deadline, std::memory_order_relaxed);
+        }
+
+        void cancel() {
+            cancelled_.store(true, std::memory_order_release);
+        }
+
+        // Cancel the parents too, i.e. the whole search
+        void cancelAll() {
+            for (auto token = this; token != nullptr; token = token->parent_) {
+                token->cancel();
+            }
+        }
+
+        [[nodiscard]] bool cancelled() const {
+            return cancelled_.load(std::memory_order_relaxed) || (parent_ != nullptr && parent_->cancelled());
+        }
+
+        // Cancel if the deadline has passed
+        bool poll() {
+            auto deadline = deadline_.load(std::memory_order_relaxed);
+            if (deadline != 0 && deadline <= now()) {
+                cancel();
+            }
+
+            if (parent_ != nullptr) {
+                parent_->poll();
+            }
+
+            return cancelled();
+        }
+
+    private:
+        CancellationToken *const parent_;
+
+        std::atomic<bool> cancelled_ = false;
+        std::atomic<int64_t> deadline_ = 0;
+    };
+}
+
+#endif //FINDER_CANCELLATION_HPP
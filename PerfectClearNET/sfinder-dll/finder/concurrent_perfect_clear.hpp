@@ -4,16 +4,80 @@
 #include "types.hpp"
 #include "perfect_clear.hpp"
 #include "thread_pool.hpp"
+#include "transposition_table.hpp"
+#include "shared_bound.hpp"
+#include "splitter.hpp"
+#include "cancellation.hpp"
+#include "pc_database.hpp"
+#include "query_profile.hpp"
+#include "search_arena.hpp"
 
 #include "../core/moves.hpp"
 
 namespace finder {
+    namespace {
+        // The candidate before the first piece is placed
+        template<class C>
+        C initialCandidate(
+                const std::vector<core::PieceType> &pieces, int maxLine, bool holdEmpty, int initCombo, bool initB2b
+        );
+
+        template<>
+        inline FastCandidate initialCandidate(
+                const std::vector<core::PieceType> &pieces, int maxLine, bool holdEmpty, int initCombo, bool initB2b
+        ) {
+            return holdEmpty
+                   ? FastCandidate{0, -1, maxLine, 0, 0, 0, 0,
+                                   initCombo, initCombo, 0}
+                   : FastCandidate{1, 0, maxLine, 0, 0, 0, 0,
+                                   initCombo, initCombo, 0};
+        }
+
+        template<>
+        inline TSpinCandidate initialCandidate(
+                const std::vector<core::PieceType> &pieces, int maxLine, bool holdEmpty, int initCombo, bool initB2b
+        ) {
+            // Count up T
+            int leftNumOfT = std::count(pieces.begin(), pieces.end(), core::PieceType::T);
+
+            return holdEmpty
+                   ? TSpinCandidate{0, -1, maxLine, 0, 0, 0, 0,
+                                    initCombo, initCombo, 0, initB2b, leftNumOfT, 0}
+                   : TSpinCandidate{1, 0, maxLine, 0, 0, 0, 0,
+                                    initCombo, initCombo, 0, initB2b, leftNumOfT, 0};
+        }
+
+        template<>
+        inline AllSpinsCandidate initialCandidate(
+                const std::vector<core::PieceType> &pieces, int maxLine, bool holdEmpty, int initCombo, bool initB2b
+        ) {
+            return holdEmpty
+                   ? AllSpinsCandidate{0, -1, maxLine, 0, 0, 0, 0,
+                                       initCombo, initCombo, 0, initB2b, 0}
+                   : AllSpinsCandidate{1, 0, maxLine, 0, 0, 0, 0,
+                                       initCombo, initCombo, 0, initB2b, 0};
+        }
+
+        template<>
+        inline TETRIOS2Candidate initialCandidate(
+                const std::vector<core::PieceType> &pieces, int maxLine, bool holdEmpty, int initCombo, bool initB2b
+        ) {
+            return holdEmpty
+                   ? TETRIOS2Candidate{0, -1, maxLine, 0, 0, 0, 0,
+                                       initCombo, initCombo, 0, initB2b, 0, false, false}
+                   : TETRIOS2Candidate{1, 0, maxLine, 0, 0, 0, 0,
+                                       initCombo, initCombo, 0, initB2b, 0, false, false};
+        }
+    }
+
     // Entry point to find best perfect clear
     template<bool Allow180 = false, bool AllowSoftdropTap = true, class M = core::srs::MoveGenerator<Allow180, AllowSoftdropTap>>
     class ConcurrentPerfectClearFinder {
     public:
-        ConcurrentPerfectClearFinder(const core::Factory &factory, ThreadPool &threadPool)
-                : factory_(factory), threadPool_(threadPool),
+        ConcurrentPerfectClearFinder(
+                const core::Factory &factory, ThreadPool &threadPool, TranspositionTable &table, CancellationToken &token,
+                const PCDatabase &database
+        ) : factory_(factory), threadPool_(threadPool), table_(table), token_(token), database_(database),
                   moveGenerator_(M(factory)), reachable_(core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap>(factory)) {
         }
 
@@ -25,17 +89,20 @@ namespace finder {
         ) {
             if (maxDepth == 1) {
                 auto moveGenerator = M(factory_);
-                auto finder = PerfectClearFinder<Allow180, AllowSoftdropTap, M>(factory_, moveGenerator);
-                return finder.run(
+                auto finder = PerfectClearFinder<Allow180, AllowSoftdropTap, M>(factory_, moveGenerator, token_);
+                return remember(finder.run(
                         field, pieces, maxDepth, maxLine, holdEmpty, holdAllowed, leastLineClears,
 						searchTypes, initCombo, initB2b, alwaysRegularAttack, lastHoldPriority, fastSearchStartDepth
-                );
+                ));
             }
 
             assert(1 < maxDepth);
 
             abort();
 
+            // Dead states depend on the queue, so forget the previous search
+            table_.nextGeneration();
+
             // Copy field
             auto freeze = core::Field(field);
 
@@ -54,480 +121,27 @@ namespace finder {
                     leastLineClears,
                     alwaysRegularAttack,
                     lastHoldPriority,
+                    topK_,
             };
 
             switch (searchTypes) {
                 case SearchTypes::Fast: {
-                    using Candidate = FastCandidate;
-                    using Record = FastRecord;
-
-                    // Create candidate
-                    auto candidate = holdEmpty
-                                     ? Candidate{0, -1, maxLine, 0, 0, 0, 0,
-                                                 initCombo, initCombo, 0}
-                                     : Candidate{1, 0, maxLine, 0, 0, 0, 0,
-                                                 initCombo, initCombo, 0};
-
-                    // premove
-                    auto moves = std::vector<core::Move>{};
-                    auto preOperations = std::vector<PreOperation<Candidate>>{};
-                    premove(
-							originalConfigure, freeze, candidate,
-                            moveGenerator_, reachable_, moves, preOperations
-                    );
-
-                    // Find solution by concurrent
-                    Recorder<Candidate, Record> recorder{};
-                    boost::mutex mutex;
-
-                    auto futures = std::vector<boost::future<bool>>(preOperations.size());
-
-                    for (int index = 0; index < futures.size(); ++index) {
-                        auto preOperation = preOperations[index];
-                        Callable<bool> callable = [&, preOperation](const TaskStatus &taskStatus) {
-                            if (taskStatus.notWorking()) {
-                                return false;
-                            }
-
-                            // Initialize moves
-                            auto movePool = std::vector<std::vector<core::Move>>{};
-                            for (int index = 0; index < maxDepth; ++index) {
-                                movePool.emplace_back();
-                            }
-
-                            auto scoredMovePool = std::vector<std::vector<core::ScoredMove>>{};
-                            for (int index = 0; index < maxDepth; ++index) {
-                                scoredMovePool.emplace_back();
-                            }
-
-                            // Initialize configure
-                            const auto configure = Configure{
-                                    pieces,
-                                    movePool,
-                                    scoredMovePool,
-                                    maxDepth,
-                                    fastSearchStartDepth,
-                                    static_cast<int>(pieces.size()),
-									holdAllowed,
-                                    leastLineClears,
-                                    alwaysRegularAttack,
-                                    lastHoldPriority,
-                            };
-
-                            auto moveGenerator = M(factory_);
-                            auto reachable = core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap>(factory_);
-                            auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M, Candidate, Record>(
-                                    factory_, moveGenerator, reachable
-                            );
-
-                            Record record;
-                            {
-                                boost::lock_guard<boost::mutex> guard(mutex);
-                                record = recorder.best();
-                            }
-
-                            if (record.solution.empty()) {
-                                record = finder.runRecord(configure, preOperation.field, preOperation.candidate);
-                            } else {
-                                record = finder.runRecord(
-                                        configure, preOperation.field, preOperation.candidate, record
-                                );
-                            }
-
-                            if (record.solution.empty()) {
-                                return false;
-                            }
-
-                            record.solution[0].pieceType = preOperation.pieceType;
-                            record.solution[0].rotateType = preOperation.rotateType;
-                            record.solution[0].x = preOperation.x;
-                            record.solution[0].y = preOperation.y;
-
-                            auto newRecord = Candidate{
-                                    record.currentIndex,
-                                    record.holdIndex, record.leftLine,
-                                    record.depth, record.softdropCount,
-                                    record.holdCount, record.lineClearCount,
-                                    record.currentCombo, record.maxCombo,
-                                    record.frames
-                            };
-
-                            {
-                                boost::lock_guard<boost::mutex> guard(mutex);
-                                if (recorder.shouldUpdate(originalConfigure, newRecord)) {
-                                    recorder.update(originalConfigure, newRecord, record.solution);
-                                }
-                            }
-
-                            return true;
-                        };
-                        futures[index] = threadPool_.execute(callable);
-                    }
-
-                    // Wait
-                    for (auto &future : futures) {
-                        future.get();
-                    }
-
-                    // Return solution
-                    auto best = recorder.best();
-                    return best.solution.empty() ? kNoSolution : std::vector<Operation>(best.solution);
+                    auto candidate = initialCandidate<FastCandidate>(pieces, maxLine, holdEmpty, initCombo, initB2b);
+                    return search<FastCandidate, FastRecord>(originalConfigure, freeze, candidate);
                 }
                 case SearchTypes::TSpin: {
                     assert(!alwaysRegularAttack);  // Support no mini only
 
-                    using Candidate = TSpinCandidate;
-                    using Record = TSpinRecord;
-
-                    // Count up T
-                    int leftNumOfT = std::count(pieces.begin(), pieces.end(), core::PieceType::T);
-
-                    // Create candidate
-                    auto candidate = holdEmpty
-                                     ? Candidate{0, -1, maxLine, 0, 0, 0, 0,
-                                                 initCombo, initCombo, 0, initB2b, leftNumOfT, 0}
-                                     : Candidate{1, 0, maxLine, 0, 0, 0, 0,
-                                                 initCombo, initCombo, 0, initB2b, leftNumOfT, 0};
-
-                    // premove
-                    auto moves = std::vector<core::Move>{};
-                    auto firstCandidates = std::vector<PreOperation<Candidate>>{};
-                    premove(
-							originalConfigure, freeze, candidate,
-                            moveGenerator_, reachable_, moves, firstCandidates
-                    );
-
-                    // Find solution by concurrent
-                    Recorder<Candidate, Record> recorder{};
-                    boost::mutex mutex;
-
-                    auto futures = std::vector<boost::future<bool>>(firstCandidates.size());
-
-                    for (int index = 0; index < futures.size(); ++index) {
-                        auto preOperation = firstCandidates[index];
-                        Callable<bool> callable = [&, preOperation](const TaskStatus &taskStatus) {
-                            if (taskStatus.notWorking()) {
-                                return false;
-                            }
-
-                            // Initialize moves
-                            auto movePool = std::vector<std::vector<core::Move>>{};
-                            for (int index = 0; index < maxDepth; ++index) {
-                                movePool.emplace_back();
-                            }
-
-                            auto scoredMovePool = std::vector<std::vector<core::ScoredMove>>{};
-                            for (int index = 0; index < maxDepth; ++index) {
-                                scoredMovePool.emplace_back();
-                            }
-
-                            // Initialize configure
-                            const auto configure = Configure{
-                                    pieces,
-                                    movePool,
-                                    scoredMovePool,
-                                    maxDepth,
-                                    fastSearchStartDepth,
-                                    static_cast<int>(pieces.size()),
-									holdAllowed,
-                                    leastLineClears,
-                                    alwaysRegularAttack,
-                                    lastHoldPriority,
-                            };
-
-                            auto moveGenerator = M(factory_);
-                            auto reachable = core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap>(factory_);
-                            auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M>(
-                                factory_, moveGenerator, reachable
-                            );
-
-                            Record record;
-                            {
-                                boost::lock_guard<boost::mutex> guard(mutex);
-                                record = recorder.best();
-                            }
-
-                            if (record.solution.empty()) {
-                                record = finder.runRecord(configure, preOperation.field, preOperation.candidate);
-                            } else {
-                                record = finder.runRecord(
-                                        configure, preOperation.field, preOperation.candidate, record
-                                );
-                            }
-
-                            if (record.solution.empty()) {
-                                return false;
-                            }
-
-                            record.solution[0].pieceType = preOperation.pieceType;
-                            record.solution[0].rotateType = preOperation.rotateType;
-                            record.solution[0].x = preOperation.x;
-                            record.solution[0].y = preOperation.y;
-
-                            auto newRecord = Candidate{
-                                    record.currentIndex,
-                                    record.holdIndex, record.leftLine,
-                                    record.depth, record.softdropCount,
-                                    record.holdCount, record.lineClearCount,
-                                    record.currentCombo, record.maxCombo,
-                                    record.tSpinAttack, record.b2b,
-                                    record.leftNumOfT, record.frames
-                            };
-
-                            {
-                                boost::lock_guard<boost::mutex> guard(mutex);
-                                if (recorder.shouldUpdate(originalConfigure, newRecord)) {
-                                    recorder.update(originalConfigure, newRecord, record.solution);
-                                }
-                            }
-
-                            return true;
-                        };
-                        futures[index] = threadPool_.execute(callable);
-                    }
-
-                    // Wait
-                    for (auto &future : futures) {
-                        future.get();
-                    }
-
-                    // Return solution
-                    auto best = recorder.best();
-                    return best.solution.empty() ? kNoSolution : std::vector<Operation>(best.solution);
+                    auto candidate = initialCandidate<TSpinCandidate>(pieces, maxLine, holdEmpty, initCombo, initB2b);
+                    return search<TSpinCandidate, TSpinRecord>(originalConfigure, freeze, candidate);
                 }
                 case SearchTypes::AllSpins: {
-                    using Candidate = AllSpinsCandidate;
-                    using Record = AllSpinsRecord;
-
-                    // Create candidate
-                    auto candidate = holdEmpty
-                                     ? Candidate{0, -1, maxLine, 0, 0, 0, 0,
-                                                 initCombo, initCombo, 0, initB2b, 0}
-                                     : Candidate{1, 0, maxLine, 0, 0, 0, 0,
-                                                 initCombo, initCombo, 0, initB2b, 0};
-
-                    // premove
-                    auto moves = std::vector<core::Move>{};
-                    auto firstCandidates = std::vector<PreOperation<Candidate>>{};
-                    premove(
-							originalConfigure, freeze, candidate,
-                            moveGenerator_, reachable_, moves, firstCandidates
-                    );
-
-                    // Find solution by concurrent
-                    Recorder<Candidate, Record> recorder{};
-                    boost::mutex mutex;
-
-                    auto futures = std::vector<boost::future<bool>>(firstCandidates.size());
-
-                    for (int index = 0; index < futures.size(); ++index) {
-                        auto preOperation = firstCandidates[index];
-                        Callable<bool> callable = [&, preOperation](const TaskStatus &taskStatus) {
-                            if (taskStatus.notWorking()) {
-                                return false;
-                            }
-
-                            // Initialize moves
-                            auto movePool = std::vector<std::vector<core::Move>>{};
-                            for (int index = 0; index < maxDepth; ++index) {
-                                movePool.emplace_back();
-                            }
-
-                            auto scoredMovePool = std::vector<std::vector<core::ScoredMove>>{};
-                            for (int index = 0; index < maxDepth; ++index) {
-                                scoredMovePool.emplace_back();
-                            }
-
-                            // Initialize configure
-                            const auto configure = Configure{
-                                    pieces,
-                                    movePool,
-                                    scoredMovePool,
-                                    maxDepth,
-                                    fastSearchStartDepth,
-                                    static_cast<int>(pieces.size()),
-									holdAllowed,
-                                    leastLineClears,
-                                    alwaysRegularAttack,
-                                    lastHoldPriority,
-                            };
-
-                            auto moveGenerator = M(factory_);
-                            auto reachable = core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap>(factory_);
-                            auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M, Candidate, Record>(
-                                    factory_, moveGenerator, reachable
-                            );
-
-                            Record record;
-                            {
-                                boost::lock_guard<boost::mutex> guard(mutex);
-                                record = recorder.best();
-                            }
-
-                            if (record.solution.empty()) {
-                                record = finder.runRecord(configure, preOperation.field, preOperation.candidate);
-                            } else {
-                                record = finder.runRecord(
-                                        configure, preOperation.field, preOperation.candidate, record
-                                );
-                            }
-
-                            if (record.solution.empty()) {
-                                return false;
-                            }
-
-                            record.solution[0].pieceType = preOperation.pieceType;
-                            record.solution[0].rotateType = preOperation.rotateType;
-                            record.solution[0].x = preOperation.x;
-                            record.solution[0].y = preOperation.y;
-
-                            auto newRecord = Candidate{
-                                    record.currentIndex,
-                                    record.holdIndex, record.leftLine,
-                                    record.depth, record.softdropCount,
-                                    record.holdCount, record.lineClearCount,
-                                    record.currentCombo, record.maxCombo,
-                                    record.spinAttack, record.b2b,
-                                    record.frames
-                            };
-
-                            {
-                                boost::lock_guard<boost::mutex> guard(mutex);
-                                if (recorder.shouldUpdate(originalConfigure, newRecord)) {
-                                    recorder.update(originalConfigure, newRecord, record.solution);
-                                }
-                            }
-
-                            return true;
-                        };
-                        futures[index] = threadPool_.execute(callable);
-                    }
-
-                    // Wait
-                    for (auto &future : futures) {
-                        future.get();
-                    }
-
-                    // Return solution
-                    auto best = recorder.best();
-                    return best.solution.empty() ? kNoSolution : std::vector<Operation>(best.solution);
+                    auto candidate = initialCandidate<AllSpinsCandidate>(pieces, maxLine, holdEmpty, initCombo, initB2b);
+                    return search<AllSpinsCandidate, AllSpinsRecord>(originalConfigure, freeze, candidate);
                 }
                 case SearchTypes::TETRIOS2: {
-                    using Candidate = TETRIOS2Candidate;
-                    using Record = TETRIOS2Record;
-
-                    // Create candidate
-                    auto candidate = holdEmpty
-                                     ? Candidate{0, -1, maxLine, 0, 0, 0, 0,
-                                                 initCombo, initCombo, 0, initB2b, 0}
-                                     : Candidate{1, 0, maxLine, 0, 0, 0, 0,
-                                                 initCombo, initCombo, 0, initB2b, 0};
-
-                    // premove
-                    auto moves = std::vector<core::Move>{};
-                    auto firstCandidates = std::vector<PreOperation<Candidate>>{};
-                    premove(
-							originalConfigure, freeze, candidate,
-                            moveGenerator_, reachable_, moves, firstCandidates
-                    );
-
-                    // Find solution by concurrent
-                    Recorder<Candidate, Record> recorder{};
-                    boost::mutex mutex;
-
-                    auto futures = std::vector<boost::future<bool>>(firstCandidates.size());
-
-                    for (int index = 0; index < futures.size(); ++index) {
-                        auto preOperation = firstCandidates[index];
-                        Callable<bool> callable = [&, preOperation](const TaskStatus &taskStatus) {
-                            if (taskStatus.notWorking()) {
-                                return false;
-                            }
-
-                            // Initialize moves
-                            auto movePool = std::vector<std::vector<core::Move>>{};
-                            for (int index = 0; index < maxDepth; ++index) {
-                                movePool.emplace_back();
-                            }
-
-                            auto scoredMovePool = std::vector<std::vector<core::ScoredMove>>{};
-                            for (int index = 0; index < maxDepth; ++index) {
-                                scoredMovePool.emplace_back();
-                            }
-
-                            // Initialize configure
-                            const auto configure = Configure{
-                                    pieces,
-                                    movePool,
-                                    scoredMovePool,
-                                    maxDepth,
-                                    fastSearchStartDepth,
-                                    static_cast<int>(pieces.size()),
-									holdAllowed,
-                                    leastLineClears,
-                                    alwaysRegularAttack,
-                                    lastHoldPriority,
-                            };
-
-                            auto moveGenerator = M(factory_);
-                            auto reachable = core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap>(factory_);
-                            auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M, Candidate, Record>(
-                                    factory_, moveGenerator, reachable
-                            );
-
-                            Record record;
-                            {
-                                boost::lock_guard<boost::mutex> guard(mutex);
-                                record = recorder.best();
-                            }
-
-                            if (record.solution.empty()) {
-                                record = finder.runRecord(configure, preOperation.field, preOperation.candidate);
-                            } else {
-                                record = finder.runRecord(
-                                        configure, preOperation.field, preOperation.candidate, record
-                                );
-                            }
-
-                            if (record.solution.empty()) {
-                                return false;
-                            }
-
-                            record.solution[0].pieceType = preOperation.pieceType;
-                            record.solution[0].rotateType = preOperation.rotateType;
-                            record.solution[0].x = preOperation.x;
-                            record.solution[0].y = preOperation.y;
-
-                            auto newRecord = Candidate{
-                                    record.currentIndex,
-                                    record.holdIndex, record.leftLine,
-                                    record.depth, record.softdropCount,
-                                    record.holdCount, record.lineClearCount,
-                                    record.currentCombo, record.maxCombo,
-                                    record.spinAttack, record.b2b,
-                                    record.frames
-                            };
-
-                            {
-                                boost::lock_guard<boost::mutex> guard(mutex);
-                                if (recorder.shouldUpdate(originalConfigure, newRecord)) {
-                                    recorder.update(originalConfigure, newRecord, record.solution);
-                                }
-                            }
-
-                            return true;
-                        };
-                        futures[index] = threadPool_.execute(callable);
-                    }
-
-                    // Wait
-                    for (auto &future : futures) {
-                        future.get();
-                    }
-
-                    // Return solution
-                    auto best = recorder.best();
-                    return best.solution.empty() ? kNoSolution : std::vector<Operation>(best.solution);
+                    auto candidate = initialCandidate<TETRIOS2Candidate>(pieces, maxLine, holdEmpty, initCombo, initB2b);
+                    return search<TETRIOS2Candidate, TETRIOS2Record>(originalConfigure, freeze, candidate);
                 }
                 default: {
                     assert(false);
@@ -542,35 +156,33 @@ namespace finder {
                 int maxLine, bool holdEmpty, bool holdAllowed, bool leastLineClears, int searchType,
                 int initCombo, bool initB2b, bool twoLineFollowUp, int numApplyFastSearch
         ) {
+            firstSolutionTime_ = 0;
+            solutions_.clear();
+
             int numOfSpace = core::FIELD_WIDTH * maxLine - field.getNumOfBlocks();
-            if (numOfSpace % 4 != 0) {
+            // A solution holds up to `Solution::kCapacity` pieces
+            if (numOfSpace % 4 != 0 || Solution::kCapacity * 4 < numOfSpace) {
                 return kNoSolution;
             }
 
             int maxDepth = numOfSpace / 4;
+            uint8_t lastHoldPriority = lastHoldPriorityOf(pieces, maxDepth, holdEmpty, twoLineFollowUp);
+            int fastSearchStartDepth = numApplyFastSearch < maxDepth ? maxDepth - numApplyFastSearch : 0;
 
-            // Check last hold that can take 2 PC
-            uint8_t lastHoldPriority = 0U;
-            if (maxDepth + 5 <= pieces.size() && twoLineFollowUp) {
-                std::vector<core::PieceType> nextPieces(pieces.cbegin() + maxDepth, pieces.cend());
-                if (holdEmpty && canTake2LinePC(nextPieces)) {
-                    lastHoldPriority |= 0b10000000U;
-                }
-
-                for (unsigned int pieceType = 0; pieceType < 7; ++pieceType) {
-                    nextPieces[0] = static_cast<core::PieceType>(pieceType);
-                    if (canTake2LinePC(nextPieces)) {
-                        lastHoldPriority |= 1U << pieceType;
-                    }
-                }
-            }
-
-            if (lastHoldPriority == 0U) {
-                lastHoldPriority = 0b11111111U;
+            // Answer from the precomputed database if it covers the query
+            auto solution = Solution{};
+            switch (lookup(
+                    field, pieces, maxLine, holdEmpty, holdAllowed, leastLineClears, searchType,
+                    initCombo, initB2b, lastHoldPriority, solution
+            )) {
+                case PCDatabase::NoSolution:
+                    return kNoSolution;
+                case PCDatabase::Solved:
+                    return remember(solution);
+                default:
+                    break;
             }
 
-            int fastSearchStartDepth = numApplyFastSearch < maxDepth ? maxDepth - numApplyFastSearch : 0;
-
             // Decide parameters
             switch (searchType) {
 				case 0: {
@@ -617,6 +229,54 @@ namespace finder {
             }
         }
 
+        // Searches all heights of `maxLines` at the same time, and returns the solution of the lowest height that has one.
+        // `maxLines` must be in ascending order. The tasks of lower heights are queued first, so they keep priority,
+        // and the higher heights are cancelled as soon as a lower one finishes with a solution.
+        Solution run(
+                const core::Field &field, const std::vector<core::PieceType> &pieces,
+                const std::vector<int> &maxLines, bool holdEmpty, bool holdAllowed, bool leastLineClears, int searchType,
+                int initCombo, bool initB2b, bool twoLineFollowUp, int numApplyFastSearch
+        ) {
+            firstSolutionTime_ = 0;
+            solutions_.clear();
+
+            switch (searchType) {
+                case 0: {
+                    return runLines<FastCandidate, FastRecord>(
+                            field, pieces, maxLines, holdEmpty, holdAllowed, leastLineClears, searchType, SearchTypes::Fast, initCombo, initB2b,
+                            false, twoLineFollowUp, numApplyFastSearch
+                    );
+                }
+                case 1: {
+                    return runLines<TSpinCandidate, TSpinRecord>(
+                            field, pieces, maxLines, holdEmpty, holdAllowed, leastLineClears, searchType, SearchTypes::TSpin, initCombo, initB2b,
+                            false, twoLineFollowUp, numApplyFastSearch
+                    );
+                }
+                case 2: {
+                    return runLines<AllSpinsCandidate, AllSpinsRecord>(
+                            field, pieces, maxLines, holdEmpty, holdAllowed, leastLineClears, searchType, SearchTypes::AllSpins, initCombo, initB2b,
+                            true, twoLineFollowUp, numApplyFastSearch
+                    );
+                }
+                case 3: {
+                    return runLines<AllSpinsCandidate, AllSpinsRecord>(
+                            field, pieces, maxLines, holdEmpty, holdAllowed, leastLineClears, searchType, SearchTypes::AllSpins, initCombo, initB2b,
+                            false, twoLineFollowUp, numApplyFastSearch
+                    );
+                }
+                case 4: {
+                    return runLines<TETRIOS2Candidate, TETRIOS2Record>(
+                            field, pieces, maxLines, holdEmpty, holdAllowed, leastLineClears, searchType, SearchTypes::TETRIOS2, initCombo, initB2b,
+                            true, twoLineFollowUp, numApplyFastSearch
+                    );
+                }
+                default: {
+                    throw std::runtime_error("Illegal search type: value=" + std::to_string(searchType));
+                }
+            }
+        }
+
 		Solution run(
                 const core::Field &field, const std::vector<core::PieceType> &pieces,
                 int maxLine, bool holdEmpty, bool holdAllowed, int searchType, bool leastLineClears,
@@ -641,7 +301,485 @@ namespace finder {
             threadPool_.abort();
         }
 
+        // When the last `run` first found a perfect clear, as `CancellationToken::now()`.
+        // 0 if no task found one, e.g. the database answered it or no solution exists.
+        [[nodiscard]] int64_t firstSolutionTime() const {
+            return firstSolutionTime_;
+        }
+
+        // The times of the phases run by the finder, added up until the caller clears it
+        QueryProfile &profile() {
+            return profile_;
+        }
+
+        // Keeps the `k` best distinct solutions of each search instead of only the best.
+        // The search prunes against the K-th best, so it visits more nodes as `k` grows.
+        void setTopK(int k) {
+            topK_ = std::max(k, 1);
+        }
+
+        // Streams every perfect clear the searches reach, from the worker threads. Pruned subtrees are not reached,
+        // so this is every solution that could be among the K best. An empty listener stops streaming.
+        void setListener(SolutionListener listener) {
+            listener_ = std::move(listener);
+        }
+
+        // The best distinct solutions of the last `run`, from the best: the returned solution, then up to K - 1 others.
+        // Empty if no solution was found.
+        [[nodiscard]] const std::vector<Solution> &solutions() const {
+            return solutions_;
+        }
+
     private:
+        // State shared by all tasks of one search
+        template<class C, class R>
+        struct Shared {
+            const Configure &configure;
+            CancellationToken &token;
+            Recorder<C, R> recorder;
+            TopKRecorder<C, R> topK;
+            SharedBound bound;
+            Splitter<C> splitter;
+            boost::mutex mutex;
+            std::vector<boost::future<bool>> futures;
+        };
+
+        // The subtree a queued task searches. The callable holds only a pointer to it, small enough to be stored inline,
+        // and payloads are recycled through `taskPool()`.
+        template<class C, class R>
+        struct Task {
+            Shared<C, R> *shared;
+            core::Field field;
+            C candidate;
+            Solution solution;
+            int64_t queuedAt;
+        };
+
+        // The move generator and reachability checker of a worker, kept for the life of the thread.
+        // They are reused by all tasks and searches of the thread, with their caches and the last flood warm.
+        struct WorkerContext {
+            explicit WorkerContext(const core::Factory &factory)
+                    : factory(factory), moveGenerator(factory), reachable(factory) {
+            }
+
+            const core::Factory &factory;
+            M moveGenerator;
+            core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> reachable;
+        };
+
+        // Rebuilt only when the factory changes
+        WorkerContext &localContext() const {
+            thread_local std::unique_ptr<WorkerContext> context{};
+
+            if (context == nullptr || &context->factory != &factory_) {
+                context = std::make_unique<WorkerContext>(factory_);
+            }
+
+            return *context;
+        }
+
+        // Never destroyed, since workers may still release payloads while the static objects are destroyed
+        template<class C, class R>
+        static ObjectPool<Task<C, R>> &taskPool() {
+            static auto pool = new ObjectPool<Task<C, R>>{};
+            return *pool;
+        }
+
+        // One height of the speculative search. Its tasks can be cancelled apart from the others.
+        template<class C, class R>
+        struct Line {
+            Line(
+                    ConcurrentPerfectClearFinder &finder, WorkerLoad &load, CancellationToken &parent,
+                    const std::vector<core::PieceType> &pieces, int maxDepth, int fastSearchStartDepth,
+                    bool holdAllowed, bool leastLineClears, bool alwaysRegularAttack, uint8_t lastHoldPriority
+            ) : configure{
+                    pieces,
+                    movePool,
+                    scoredMovePool,
+                    maxDepth,
+                    fastSearchStartDepth,
+                    static_cast<int>(pieces.size()),
+                    holdAllowed,
+                    leastLineClears,
+                    alwaysRegularAttack,
+                    lastHoldPriority,
+                    finder.topK_,
+            }, token(&parent), shared{
+                    configure,
+                    token,
+                    Recorder<C, R>{},
+                    TopKRecorder<C, R>(configure.topK),
+                    SharedBound{},
+                    Splitter<C>(load, [&finder, this](const core::Field &field, const C &candidate, const Solution &solution) {
+                        return finder.submit(shared, field, candidate, solution);
+                    }),
+            } {
+            }
+
+            std::vector<std::vector<core::Move>> movePool{};
+            std::vector<std::vector<core::ScoredMove>> scoredMovePool{};
+            const Configure configure;
+            CancellationToken token;
+            Shared<C, R> shared;
+        };
+
+        template<class C, class R>
+        Solution runLines(
+                const core::Field &field, const std::vector<core::PieceType> &pieces,
+                const std::vector<int> &maxLines, bool holdEmpty, bool holdAllowed, bool leastLineClears,
+                int searchType, SearchTypes searchTypes, int initCombo, bool initB2b, bool alwaysRegularAttack,
+                bool twoLineFollowUp, int numApplyFastSearch
+        ) {
+            WorkerLoad load(threadPool_);
+            std::vector<std::unique_ptr<Line<C, R>>> lines{};
+
+            // The solution of a height known from the database, used if none of the lower heights has one
+            auto known = kNoSolution;
+
+            for (auto maxLine : maxLines) {
+                int numOfSpace = core::FIELD_WIDTH * maxLine - field.getNumOfBlocks();
+                if (numOfSpace % 4 != 0 || Solution::kCapacity * 4 < numOfSpace) {
+                    continue;
+                }
+
+                int maxDepth = numOfSpace / 4;
+                uint8_t lastHoldPriority = lastHoldPriorityOf(pieces, maxDepth, holdEmpty, twoLineFollowUp);
+                int fastSearchStartDepth = numApplyFastSearch < maxDepth ? maxDepth - numApplyFastSearch : 0;
+
+                auto solution = Solution{};
+                auto status = lookup(
+                        field, pieces, maxLine, holdEmpty, holdAllowed, leastLineClears, searchType,
+                        initCombo, initB2b, lastHoldPriority, solution
+                );
+                if (status == PCDatabase::NoSolution) {
+                    continue;
+                }
+                if (status == PCDatabase::Solved) {
+                    if (lines.empty()) {
+                        return remember(solution);
+                    }
+
+                    // The higher heights are never needed
+                    known = solution;
+                    break;
+                }
+
+                if (maxDepth == 1) {
+                    // Only the lowest height can be a single piece. It is not worth any task.
+                    solution = run(
+                            field, pieces, maxDepth, maxLine, holdEmpty, holdAllowed, leastLineClears, searchTypes,
+                            initCombo, initB2b, alwaysRegularAttack, lastHoldPriority, fastSearchStartDepth
+                    );
+                    if (!solution.empty()) {
+                        return solution;
+                    }
+                    continue;
+                }
+
+                if (lines.empty()) {
+                    abort();
+
+                    // Dead states depend on the queue, so forget the previous search.
+                    // The heights can share the generation: the states of different heights never have the same key.
+                    table_.nextGeneration();
+                }
+
+                auto line = std::make_unique<Line<C, R>>(
+                        *this, load, token_, pieces, maxDepth, fastSearchStartDepth,
+                        holdAllowed, leastLineClears, alwaysRegularAttack, lastHoldPriority
+                );
+
+                start(line->shared, field, initialCandidate<C>(pieces, maxLine, holdEmpty, initCombo, initB2b));
+                lines.push_back(std::move(line));
+            }
+
+            // Wait from the lowest height. The first solution wins, so the higher heights are not needed anymore.
+            auto solution = kNoSolution;
+            for (auto &line : lines) {
+                if (solution.empty()) {
+                    solution = wait(line->shared);
+                    if (!solution.empty()) {
+                        solutions_ = solutionsOf(line->shared, solution);
+                    }
+                } else {
+                    line->token.cancel();
+                    wait(line->shared);
+                }
+            }
+
+            return solution.empty() ? remember(known) : solution;
+        }
+
+        template<class C, class R>
+        Solution search(const Configure &originalConfigure, const core::Field &field, const C &candidate) {
+            // Find solution by concurrent
+            WorkerLoad load(threadPool_);
+            Shared<C, R> shared{
+                    originalConfigure,
+                    token_,
+                    Recorder<C, R>{},
+                    TopKRecorder<C, R>(originalConfigure.topK),
+                    SharedBound{},
+                    Splitter<C>(load, [&](const core::Field &field, const C &candidate, const Solution &solution) {
+                        return submit(shared, field, candidate, solution);
+                    }),
+            };
+
+            start(shared, field, candidate);
+
+            auto solution = wait(shared);
+            solutions_ = solutionsOf(shared, solution);
+            return solution;
+        }
+
+        // The best solution first, then the other kept ones in order
+        template<class C, class R>
+        std::vector<Solution> solutionsOf(const Shared<C, R> &shared, const Solution &best) const {
+            std::vector<Solution> solutions{};
+            if (best.empty()) {
+                return solutions;
+            }
+
+            solutions.push_back(best);
+            for (const auto &record : shared.topK.records(shared.configure)) {
+                if (shared.configure.topK <= static_cast<int>(solutions.size())) {
+                    break;
+                }
+
+                if (!isSameSolution(record.solution, best)) {
+                    solutions.push_back(record.solution);
+                }
+            }
+
+            return solutions;
+        }
+
+        // A solution found without searching is the only one, and is streamed as if the search found it
+        Solution remember(const Solution &solution) {
+            solutions_.clear();
+            if (!solution.empty()) {
+                solutions_.push_back(solution);
+
+                if (listener_) {
+                    listener_(solution);
+                }
+            }
+
+            return solution;
+        }
+
+        // Queue the tasks for the subtrees of the first pieces
+        template<class C, class R>
+        void start(Shared<C, R> &shared, const core::Field &field, const C &candidate) {
+            auto &originalConfigure = shared.configure;
+
+            // premove
+            auto moves = std::vector<core::Move>{};
+            auto preOperations = std::vector<PreOperation<C>>{};
+            {
+                QueryTimer timer(profile_, QueryPhase::Premove);
+                premove(
+                        originalConfigure, field, candidate,
+                        moveGenerator_, reachable_, moves, preOperations
+                );
+            }
+
+            QueryTimer timer(profile_, QueryPhase::Dispatch);
+            for (const auto &preOperation : preOperations) {
+                Solution solution(originalConfigure.maxDepth);
+                std::fill(solution.begin(), solution.end(), Operation{
+                        core::PieceType::T, core::RotateType::Spawn, -1, -1
+                });
+                solution[0] = Operation{preOperation.pieceType, preOperation.rotateType, preOperation.x, preOperation.y};
+
+                if (!submit(shared, preOperation.field, preOperation.candidate, solution)) {
+                    break;
+                }
+            }
+        }
+
+        template<class C, class R>
+        Solution wait(Shared<C, R> &shared) {
+            QueryTimer timer(profile_, QueryPhase::Search);
+
+            // Wait. Tasks may add subtrees split off from them until they are completed.
+            while (true) {
+                boost::future<bool> future;
+                {
+                    boost::lock_guard<boost::mutex> guard(shared.mutex);
+                    if (shared.futures.empty()) {
+                        break;
+                    }
+
+                    future = std::move(shared.futures.back());
+                    shared.futures.pop_back();
+                }
+
+                future.get();
+            }
+
+            auto firstTime = shared.bound.firstTime();
+            if (firstTime != 0 && (firstSolutionTime_ == 0 || firstTime < firstSolutionTime_)) {
+                firstSolutionTime_ = firstTime;
+            }
+
+            // Return solution
+            auto best = shared.recorder.best();
+            return best.solution;
+        }
+
+        // Queue the subtree of `candidate`. Returns false if the pool no longer accepts tasks (e.g. while aborting).
+        template<class C, class R>
+        bool submit(Shared<C, R> &shared, const core::Field &field, const C &candidate, const Solution &solution) {
+            auto task = taskPool<C, R>().acquire();
+            task->shared = &shared;
+            task->field = field;
+            task->candidate = candidate;
+            task->solution = solution;
+            task->queuedAt = CancellationToken::now();
+
+            Callable<bool> callable = [this, task](const TaskStatus &taskStatus) {
+                profile_.started(CancellationToken::now() - task->queuedAt);
+
+                auto &shared = *task->shared;
+                shared.splitter.started();
+                bool found = taskStatus.working() && !shared.token.cancelled()
+                             && runTask(shared, task->field, task->candidate, task->solution);
+                taskPool<C, R>().release(task);
+                shared.splitter.finished();
+                return found;
+            };
+
+            shared.splitter.queued();
+
+            boost::lock_guard<boost::mutex> guard(shared.mutex);
+            try {
+                shared.futures.push_back(threadPool_.execute(callable));
+            } catch (const std::runtime_error &) {
+                taskPool<C, R>().release(task);
+                shared.splitter.dropped();
+                return false;
+            }
+
+            return true;
+        }
+
+        template<class C, class R>
+        bool runTask(Shared<C, R> &shared, const core::Field &field, const C &candidate, Solution &solution) {
+            auto &originalConfigure = shared.configure;
+            auto maxDepth = originalConfigure.maxDepth;
+
+            // Borrow the move buffers of this worker
+            ArenaLease lease(maxDepth);
+
+            // Initialize configure
+            const auto configure = Configure{
+                    originalConfigure.pieces,
+                    lease.arena.movePool,
+                    lease.arena.scoredMovePool,
+                    maxDepth,
+                    originalConfigure.fastSearchStartDepth,
+                    originalConfigure.pieceSize,
+                    originalConfigure.holdAllowed,
+                    originalConfigure.leastLineClears,
+                    originalConfigure.alwaysRegularAttack,
+                    originalConfigure.lastHoldPriority,
+                    originalConfigure.topK,
+            };
+
+            auto &context = localContext();
+            auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M, C, R>(
+                    factory_, context.moveGenerator, context.reachable, shared.token, &table_, &shared.bound, &shared.splitter,
+                    &listener_
+            );
+
+            R record;
+            {
+                boost::lock_guard<boost::mutex> guard(shared.mutex);
+                record = shared.recorder.best();
+            }
+
+            if (record.solution.empty()) {
+                record = finder.runRecord(configure, field, candidate, solution);
+            } else {
+                record = finder.runRecord(configure, field, candidate, record, solution);
+            }
+
+            if (record.solution.empty()) {
+                return false;
+            }
+
+            auto newRecord = toCandidate(record);
+
+            {
+                boost::lock_guard<boost::mutex> guard(shared.mutex);
+                if (shared.recorder.shouldUpdate(originalConfigure, newRecord)) {
+                    shared.recorder.update(originalConfigure, newRecord, record.solution);
+                }
+
+                // The K-th best of all tasks may prune more than that of any single task
+                if (1 < originalConfigure.topK) {
+                    shared.topK.add(originalConfigure, finder.records());
+                    if (shared.topK.full()) {
+                        shared.bound.publish(shared.topK.worst().bound());
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        PCDatabase::Status lookup(
+                const core::Field &field, const std::vector<core::PieceType> &pieces, int maxLine,
+                bool holdEmpty, bool holdAllowed, bool leastLineClears, int searchType,
+                int initCombo, bool initB2b, uint8_t lastHoldPriority, Solution &solution
+        ) {
+            // The database is generated with hold
+            if (!database_.opened() || !holdAllowed) {
+                return PCDatabase::Unknown;
+            }
+
+            QueryTimer timer(profile_, QueryPhase::Lookup);
+
+            auto status = database_.find(
+                    field, maxLine, pieces, PCDatabase::Parameters{searchType, holdEmpty, leastLineClears, initB2b, initCombo},
+                    solution
+            );
+
+            // The best solution also depends on the pieces after it when a 2-line PC should follow
+            if (status == PCDatabase::Solved && lastHoldPriority != 0b11111111U) {
+                return PCDatabase::Unknown;
+            }
+
+            return status;
+        }
+
+        uint8_t lastHoldPriorityOf(
+                const std::vector<core::PieceType> &pieces, int maxDepth, bool holdEmpty, bool twoLineFollowUp
+        ) const {
+            // Check last hold that can take 2 PC
+            uint8_t lastHoldPriority = 0U;
+            if (maxDepth + 5 <= pieces.size() && twoLineFollowUp) {
+                std::vector<core::PieceType> nextPieces(pieces.cbegin() + maxDepth, pieces.cend());
+                if (holdEmpty && canTake2LinePC(nextPieces)) {
+                    lastHoldPriority |= 0b10000000U;
+                }
+
+                for (unsigned int pieceType = 0; pieceType < 7; ++pieceType) {
+                    nextPieces[0] = static_cast<core::PieceType>(pieceType);
+                    if (canTake2LinePC(nextPieces)) {
+                        lastHoldPriority |= 1U << pieceType;
+                    }
+                }
+            }
+
+            if (lastHoldPriority == 0U) {
+                lastHoldPriority = 0b11111111U;
+            }
+
+            return lastHoldPriority;
+        }
+
         template<class C>
         void premove(
                 const Configure &configure,
@@ -717,8 +855,16 @@ namespace finder {
 
         const core::Factory &factory_;
         ThreadPool &threadPool_;
+        TranspositionTable &table_;
+        CancellationToken &token_;
+        const PCDatabase &database_;
         M moveGenerator_;
         core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> reachable_;
+        int64_t firstSolutionTime_ = 0;
+        QueryProfile profile_{};
+        int topK_ = 1;
+        SolutionListener listener_{};
+        std::vector<Solution> solutions_{};
     };
 }
 
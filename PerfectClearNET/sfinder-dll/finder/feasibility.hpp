@@ -0,0 +1,164 @@
+#ifndef FINDER_FEASIBILITY_HPP
+#define FINDER_FEASIBILITY_HPP
+
+#include <array>
+
+#include "types.hpp"
+
+#include "../core/bits.hpp"
+#include "../core/field.hpp"
+
+namespace finder {
+    // Cheap necessary conditions for a perfect clear, checked on every state after `validate`.
+    // Each stage compares what the empty cells demand with the pieces that can still be placed.
+    // A stage must hold for any order of line clears, since rows may be cleared before the last piece.
+    class Feasibility {
+    public:
+        // Number of each piece type that the rest of the solution places
+        using Inventory = std::array<int, 7>;
+
+        static bool check(
+                const Configure &configure, const core::Field &field,
+                int leftLine, int currentIndex, int holdIndex, int depth
+        ) {
+            int columnParity = getColumnParity(field, leftLine);
+            int requiredI = getRequiredI(field, leftLine);
+            if (requiredI < 0) {
+                return false;
+            }
+
+            // The next pieces that may be placed. With hold, any one of them can be left over at the end.
+            int numOfPieces = configure.maxDepth - depth;
+            int windowSize = configure.holdAllowed ? numOfPieces + 1 : numOfPieces;
+
+            Inventory window{};
+            int size = 0;
+            if (configure.holdAllowed && 0 <= holdIndex) {
+                window[configure.pieces[holdIndex]] += 1;
+                size += 1;
+            }
+            for (int index = currentIndex; index < configure.pieceSize && size < windowSize; ++index) {
+                window[configure.pieces[index]] += 1;
+                size += 1;
+            }
+
+            if (size < numOfPieces) {
+                return false;
+            }
+
+            if (size == numOfPieces) {
+                return isEnough(window, columnParity, requiredI);
+            }
+
+            for (int pieceType = 0; pieceType < 7; ++pieceType) {
+                if (window[pieceType] == 0) {
+                    continue;
+                }
+
+                window[pieceType] -= 1;
+                bool enough = isEnough(window, columnParity, requiredI);
+                window[pieceType] += 1;
+
+                if (enough) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+    private:
+        static constexpr core::Bitboard kRowMask = 0x3ffULL;
+        static constexpr core::Bitboard kEvenColumnsInRow = 0x155ULL;
+
+        static constexpr core::Bitboard evenColumns() {
+            core::Bitboard board = 0;
+            for (int y = 0; y < 6; ++y) {
+                board |= kEvenColumnsInRow << (y * core::FIELD_WIDTH);
+            }
+            return board;
+        }
+
+        static core::Bitboard rowOf(const core::Field &field, int y) {
+            return (field.boards[y / 6] >> (y % 6 * core::FIELD_WIDTH)) & kRowMask;
+        }
+
+        // Empty cells in even columns minus those in odd columns, halved.
+        // Line clears do not move columns, so each piece always adds the same amount:
+        // L and J add 1 or -1, vertical T 1 or -1, vertical I 2 or -2, and the others 0.
+        static int getColumnParity(const core::Field &field, int leftLine) {
+            constexpr core::Bitboard kEvenColumns = evenColumns();
+
+            int filledEven = 0;
+            int filledOdd = 0;
+            for (int index = 0; index * 6 < leftLine; ++index) {
+                int rows = leftLine - index * 6 < 6 ? leftLine - index * 6 : 6;
+                core::Bitboard mask = core::getColumnOneLineBelowY(rows) * kRowMask;
+                filledEven += core::bitCount(field.boards[index] & mask & kEvenColumns);
+                filledOdd += core::bitCount(field.boards[index] & mask & ~kEvenColumns);
+            }
+
+            return (filledOdd - filledEven) / 2;
+        }
+
+        // Number of I pieces needed for the vertical corridors reaching the top line, or -1 if one cannot be filled.
+        // Pieces stay below the top line, so a piece filling a corridor cell is vertical, or reaches below the corridor.
+        // Except for I, such a piece spans at most 3 rows, so it fills at most the 2 lowest corridor cells.
+        static int getRequiredI(const core::Field &field, int leftLine) {
+            assert(0 < leftLine);
+
+            auto corridors = walledEmptyCells(rowOf(field, leftLine - 1));
+            int requiredI = 0;
+
+            while (corridors != 0) {
+                auto bit = corridors & (~corridors + 1);
+                corridors &= corridors - 1;
+
+                int y = leftLine - 1;
+                while (0 < y && (walledEmptyCells(rowOf(field, y - 1)) & bit) != 0) {
+                    y -= 1;
+                }
+
+                int depth = leftLine - y;
+                if (y == 0) {
+                    // Standing on the floor: only I pieces fit into it
+                    if (depth % 4 != 0) {
+                        return -1;
+                    }
+                    requiredI += depth / 4;
+                } else if (3 <= depth) {
+                    requiredI += (depth + 1) / 4;
+                }
+            }
+
+            return requiredI;
+        }
+
+        // Empty cells whose left and right neighbors are blocks or walls
+        static core::Bitboard walledEmptyCells(core::Bitboard row) {
+            auto filledLeft = (row << 1U) | 1U;
+            auto filledRight = (row >> 1U) | (1U << (core::FIELD_WIDTH - 1));
+            return ~row & filledLeft & filledRight & kRowMask;
+        }
+
+        static bool isEnough(const Inventory &inventory, int columnParity, int requiredI) {
+            int numOfI = inventory[core::PieceType::I];
+            if (numOfI < requiredI) {
+                return false;
+            }
+
+            int numOfT = inventory[core::PieceType::T];
+            int numOfLJ = inventory[core::PieceType::L] + inventory[core::PieceType::J];
+
+            int parity = columnParity < 0 ? -columnParity : columnParity;
+            if (numOfLJ + numOfT + 2 * numOfI < parity) {
+                return false;
+            }
+
+            // Without T, only L and J change the parity of it
+            return 0 < numOfT || (parity - numOfLJ) % 2 == 0;
+        }
+    };
+}
+
+#endif //FINDER_FEASIBILITY_HPP
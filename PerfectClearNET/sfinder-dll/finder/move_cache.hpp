@@ -0,0 +1,219 @@
+#ifndef FINDER_MOVE_CACHE_HPP
+#define FINDER_MOVE_CACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "thread_registry.hpp"
+#include "transposition_table.hpp"
+
+#include "../core/field.hpp"
+#include "../core/moves.hpp"
+#include "../core/piece.hpp"
+
+namespace finder {
+    struct MoveCacheStats {
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+    // Remembers the moves generated for recent (field, piece type, valid height), per thread and move generator.
+    // The same field is expanded with the same piece by the current and hold branches, and again through transpositions.
+    // Moves depend only on the key and the rotation system, so entries never go stale. The cache is cleared when the factory changes.
+    //
+    // An entry fills a cache line: the key and up to `kMaxMoves` moves packed into 16 bits each, in the generated order.
+    // Longer lists are not cached. Entries are in 2-way sets, and a miss replaces the less recently used one.
+    class MoveCache {
+    public:
+        static constexpr int kSetBits = 11;
+        static constexpr int kMaxMoves = 27;
+
+        template<class M>
+        static MoveCache &local(const core::Factory &factory) {
+            thread_local MoveCache cache{};
+
+            if (cache.factory_ != &factory) {
+                std::fill(cache.sets_.get(), cache.sets_.get() + kNumOfSets, Set{});
+                cache.factory_ = &factory;
+            }
+
+            return cache;
+        }
+
+        // Sum of the caches of all threads, including the finished ones
+        static MoveCacheStats stats() {
+            return Registry::visit([](const std::vector<MoveCache *> &caches, const MoveCacheStats &retired) {
+                auto stats = retired;
+                for (auto cache : caches) {
+                    cache->addTo(stats);
+                }
+                return stats;
+            });
+        }
+
+        MoveCache() : sets_(std::make_unique<Set[]>(kNumOfSets)) {
+            Registry::add(this);
+        }
+
+        MoveCache(const MoveCache &) = delete;
+
+        MoveCache &operator=(const MoveCache &) = delete;
+
+        ~MoveCache() {
+            Registry::remove(this, [this](MoveCacheStats &retired) {
+                addTo(retired);
+            });
+        }
+
+        [[nodiscard]] static uint64_t key(const core::Field &field, core::PieceType pieceType, int validHeight) {
+            uint64_t meta = static_cast<uint64_t>(validHeight) << 3U | static_cast<uint64_t>(pieceType);
+
+            uint64_t hash = mixHash(meta);
+            hash = mixHash(hash ^ field.xBoardLow);
+            hash = mixHash(hash ^ field.xBoardMidLow);
+            hash = mixHash(hash ^ field.xBoardMidHigh);
+            hash = mixHash(hash ^ field.xBoardHigh);
+            return hash != 0 ? hash : 1;
+        }
+
+        // Appends the cached moves. Returns false on a miss.
+        bool find(uint64_t key, std::vector<core::Move> &moves) {
+            auto &set = sets_[key & kMask];
+
+            for (int way = 0; way < 2; ++way) {
+                auto &entry = set.entries[way];
+                if (entry.key != key) {
+                    continue;
+                }
+
+                for (int index = 0; index < entry.size; ++index) {
+                    moves.push_back(unpack(entry.moves[index]));
+                }
+
+                touch(set, way);
+                count(hits_);
+                return true;
+            }
+
+            count(misses_);
+            return false;
+        }
+
+        // `moves` from `begin` are the ones generated for the key
+        void store(uint64_t key, const std::vector<core::Move> &moves, size_t begin) {
+            auto size = moves.size() - begin;
+            if (static_cast<size_t>(kMaxMoves) < size) {
+                return;
+            }
+
+            auto &set = sets_[key & kMask];
+            int way = set.entries[0].recent ? 1 : 0;
+            auto &entry = set.entries[way];
+
+            entry.key = key;
+            entry.size = static_cast<uint8_t>(size);
+            for (size_t index = 0; index < size; ++index) {
+                entry.moves[index] = pack(moves[begin + index]);
+            }
+
+            touch(set, way);
+        }
+
+    private:
+        static constexpr uint64_t kNumOfSets = 1ULL << kSetBits;
+        static constexpr uint64_t kMask = kNumOfSets - 1U;
+
+        struct alignas(64) Entry {
+            uint64_t key;
+            uint8_t size;
+            bool recent;
+            uint16_t moves[kMaxMoves];
+        };
+
+        static_assert(sizeof(Entry) == 64, "An entry should fill a cache line");
+
+        struct Set {
+            Entry entries[2];
+        };
+
+        using Registry = ThreadRegistry<MoveCache, MoveCacheStats>;
+
+        // rotate: 2 bits, x: 4 bits, y: 5 bits, harddrop: 1 bit, rotation: 2 bits
+        static uint16_t pack(const core::Move &move) {
+            assert(0 <= move.x && move.x < 16 && 0 <= move.y && move.y < 32);
+            return static_cast<uint16_t>(
+                    static_cast<unsigned>(move.rotateType)
+                    | static_cast<unsigned>(move.x) << 2U
+                    | static_cast<unsigned>(move.y) << 6U
+                    | static_cast<unsigned>(move.harddrop) << 11U
+                    | static_cast<unsigned>(move.rotation) << 12U
+            );
+        }
+
+        static core::Move unpack(uint16_t packed) {
+            return core::Move{
+                    static_cast<core::RotateType>(packed & 3U),
+                    static_cast<int>(packed >> 2U & 15U),
+                    static_cast<int>(packed >> 6U & 31U),
+                    (packed >> 11U & 1U) != 0,
+                    static_cast<core::Rotation>(packed >> 12U & 3U),
+            };
+        }
+
+        static void touch(Set &set, int way) {
+            set.entries[way].recent = true;
+            set.entries[way ^ 1].recent = false;
+        }
+
+        // Only the owner thread writes the counters
+        static void count(std::atomic<uint64_t> &counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void addTo(MoveCacheStats &stats) const {
+            stats.hits += hits_.load(std::memory_order_relaxed);
+            stats.misses += misses_.load(std::memory_order_relaxed);
+        }
+
+        std::unique_ptr<Set[]> sets_;
+        const core::Factory *factory_ = nullptr;
+
+        std::atomic<uint64_t> hits_{0};
+        std::atomic<uint64_t> misses_{0};
+    };
+
+    // Looks up `MoveCache` before generating moves with `M`
+    template<class M>
+    class CachedMoveGenerator {
+    public:
+        explicit CachedMoveGenerator(const core::Factory &factory) : factory(factory), moveGenerator(factory) {
+        }
+
+        void search(std::vector<core::Move> &moves, const core::Field &field, core::PieceType pieceType, int validHeight) {
+            auto &cache = MoveCache::local<M>(factory);
+            auto key = MoveCache::key(field, pieceType, validHeight);
+
+            if (cache.find(key, moves)) {
+                return;
+            }
+
+            auto begin = moves.size();
+            moveGenerator.search(moves, field, pieceType, validHeight);
+            cache.store(key, moves, begin);
+        }
+
+        bool canReach(const core::Field &field, core::PieceType pieceType, core::RotateType rotateType, int x, int y,
+                      int validHeight) {
+            return moveGenerator.canReach(field, pieceType, rotateType, x, y, validHeight);
+        }
+
+    private:
+        const core::Factory &factory;
+        M moveGenerator;
+    };
+}
+
+#endif //FINDER_MOVE_CACHE_HPP
@@ -0,0 +1,269 @@
+#include "pc_database.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace finder {
+    namespace {
+        constexpr char kMagic[8] = {'S', 'F', 'P', 'C', 'D', 'B', 0, 0};
+
+        bool isValidHeader(const PCDatabase::FileHeader &header, uint32_t game) {
+            return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+                   && header.version == PCDatabase::kVersion && header.game == game;
+        }
+
+        // Sections of many pieces exceed the range of `long`
+        bool seek(FILE *file, int64_t offset, int origin) {
+#ifdef _WIN32
+            return _fseeki64(file, offset, origin) == 0;
+#else
+            return fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#endif
+        }
+
+        bool isValidSection(const PCDatabase::SectionHeader &header) {
+            return 0 < header.maxDepth && header.maxDepth <= Solution::kCapacity && 0 < header.maxLine
+                   && (header.numOfPieces == header.maxDepth || header.numOfPieces == header.maxDepth + 1)
+                   && header.numOfEntries == PCDatabase::numOfQueues(header.numOfPieces);
+        }
+    }
+
+    bool PCDatabase::open(const std::string &path, uint32_t game) {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(
+                path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+        );
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        file_ = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+
+        mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr) {
+            close();
+            return false;
+        }
+
+        data_ = static_cast<const uint8_t *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr) {
+            close();
+            return false;
+        }
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            return false;
+        }
+        file_ = reinterpret_cast<void *>(static_cast<intptr_t>(file) + 1);
+
+        struct stat status{};
+        if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(status.st_size);
+
+        void *data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, file, 0);
+        if (data == MAP_FAILED) {
+            close();
+            return false;
+        }
+        data_ = static_cast<const uint8_t *>(data);
+#endif
+
+        FileHeader fileHeader{};
+        std::memcpy(&fileHeader, data_, sizeof(FileHeader));
+        if (!isValidHeader(fileHeader, game)) {
+            close();
+            return false;
+        }
+
+        // Headers are not aligned after the entries, so they are copied out
+        size_t offset = sizeof(FileHeader);
+        for (uint32_t index = 0; index < fileHeader.numOfSections; ++index) {
+            if (size_ < offset + sizeof(SectionHeader)) {
+                close();
+                return false;
+            }
+
+            SectionHeader header{};
+            std::memcpy(&header, data_ + offset, sizeof(SectionHeader));
+            offset += sizeof(SectionHeader);
+
+            if (!isValidSection(header) || (size_ - offset) / entrySize(header) < header.numOfEntries) {
+                close();
+                return false;
+            }
+
+            sections_.push_back(Section{header, data_ + offset});
+            offset += entrySize(header) * header.numOfEntries;
+        }
+
+        return true;
+    }
+
+    void PCDatabase::close() {
+#ifdef _WIN32
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_ != nullptr) {
+            CloseHandle(mapping_);
+        }
+        if (file_ != nullptr) {
+            CloseHandle(file_);
+        }
+#else
+        if (data_ != nullptr) {
+            munmap(const_cast<uint8_t *>(data_), size_);
+        }
+        if (file_ != nullptr) {
+            ::close(static_cast<int>(reinterpret_cast<intptr_t>(file_) - 1));
+        }
+#endif
+
+        data_ = nullptr;
+        size_ = 0;
+        sections_.clear();
+        file_ = nullptr;
+        mapping_ = nullptr;
+    }
+
+    PCDatabase::Status PCDatabase::find(
+            const core::Field &field, int maxLine, const std::vector<core::PieceType> &pieces,
+            const Parameters &parameters, Solution &solution
+    ) const {
+        auto status = Status::Unknown;
+
+        for (const auto &section : sections_) {
+            auto &header = section.header;
+            if (header.maxLine != maxLine
+                || header.boards[0] != field.xBoardLow || header.boards[1] != field.xBoardMidLow
+                || header.boards[2] != field.xBoardMidHigh || header.boards[3] != field.xBoardHigh) {
+                continue;
+            }
+
+            // The finder never uses the pieces after the one left in hold
+            int numOfPieces = static_cast<int>(pieces.size()) < header.maxDepth + 1
+                              ? static_cast<int>(pieces.size()) : header.maxDepth + 1;
+            if (header.numOfPieces != numOfPieces) {
+                continue;
+            }
+
+            auto entry = section.entries + hash(pieces, numOfPieces) * entrySize(header);
+            if (entry[0] == Status::NoSolution) {
+                return Status::NoSolution;
+            }
+
+            // Any solution proves that one exists, but the best one depends on the parameters
+            bool sameParameters = header.searchType == parameters.searchType && header.holdEmpty == parameters.holdEmpty
+                                  && header.leastLineClears == parameters.leastLineClears
+                                  && header.initB2b == parameters.initB2b && header.initCombo == parameters.initCombo;
+            if (entry[0] != Status::Solved || !sameParameters) {
+                continue;
+            }
+
+            solution.resize(header.maxDepth);
+            for (int index = 0; index < header.maxDepth; ++index) {
+                auto operation = entry + 1 + 4 * index;
+                solution[index] = Operation{
+                        static_cast<core::PieceType>(static_cast<int8_t>(operation[0])),
+                        static_cast<core::RotateType>(static_cast<int8_t>(operation[1])),
+                        static_cast<int8_t>(operation[2]),
+                        static_cast<int8_t>(operation[3]),
+                };
+            }
+            status = Status::Solved;
+        }
+
+        return status;
+    }
+
+    void PCDatabase::toEntry(const Solution &solution, std::vector<uint8_t> &entry) {
+        std::fill(entry.begin(), entry.end(), 0);
+        entry[0] = solution.empty() ? Status::NoSolution : Status::Solved;
+
+        for (size_t index = 0; index < solution.size() && 1 + 4 * index < entry.size(); ++index) {
+            auto &operation = solution[index];
+            entry[1 + 4 * index] = static_cast<uint8_t>(operation.pieceType);
+            entry[2 + 4 * index] = static_cast<uint8_t>(operation.rotateType);
+            entry[3 + 4 * index] = static_cast<uint8_t>(operation.x);
+            entry[4 + 4 * index] = static_cast<uint8_t>(operation.y);
+        }
+    }
+
+    FILE *PCDatabase::beginSection(const std::string &path, uint32_t game, const SectionHeader &header) {
+        FILE *file = std::fopen(path.c_str(), "r+b");
+        FileHeader fileHeader{};
+
+        if (file == nullptr) {
+            file = std::fopen(path.c_str(), "w+b");
+            if (file == nullptr) {
+                return nullptr;
+            }
+
+            std::memcpy(fileHeader.magic, kMagic, sizeof(kMagic));
+            fileHeader.version = kVersion;
+            fileHeader.game = game;
+            fileHeader.numOfSections = 0;
+
+            if (std::fwrite(&fileHeader, sizeof(FileHeader), 1, file) != 1) {
+                std::fclose(file);
+                return nullptr;
+            }
+        } else if (std::fread(&fileHeader, sizeof(FileHeader), 1, file) != 1 || !isValidHeader(fileHeader, game)) {
+            std::fclose(file);
+            return nullptr;
+        }
+
+        // Skip the complete sections. Whatever follows them is left by a generation that was cancelled.
+        for (uint32_t index = 0; index < fileHeader.numOfSections; ++index) {
+            SectionHeader section{};
+            if (std::fread(&section, sizeof(SectionHeader), 1, file) != 1
+                || !seek(file, static_cast<int64_t>(entrySize(section) * section.numOfEntries), SEEK_CUR)) {
+                std::fclose(file);
+                return nullptr;
+            }
+        }
+
+        if (!seek(file, 0, SEEK_CUR) || std::fwrite(&header, sizeof(SectionHeader), 1, file) != 1) {
+            std::fclose(file);
+            return nullptr;
+        }
+
+        return file;
+    }
+
+    bool PCDatabase::endSection(FILE *file, bool written) {
+        FileHeader fileHeader{};
+        bool committed = written
+                         && seek(file, 0, SEEK_SET)
+                         && std::fread(&fileHeader, sizeof(FileHeader), 1, file) == 1;
+
+        if (committed) {
+            fileHeader.numOfSections += 1;
+            committed = seek(file, 0, SEEK_SET)
+                        && std::fwrite(&fileHeader, sizeof(FileHeader), 1, file) == 1;
+        }
+
+        return std::fclose(file) == 0 && committed;
+    }
+}
@@ -0,0 +1,199 @@
+#ifndef FINDER_PC_DATABASE_HPP
+#define FINDER_PC_DATABASE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+
+#include "../core/field.hpp"
+
+namespace finder {
+    // Precomputed results of perfect clear searches, in a file that is mapped into memory instead of parsed.
+    //
+    // A file is a header followed by sections. A section covers one field, height, number of pieces and
+    // search parameters, and has a fixed-size entry for every queue of that many pieces, stored at the hash of
+    // the queue in base 7. So a lookup is a scan of the few section headers and a single array access.
+    // The queue is the hold piece (if any) and the next pieces, i.e. the pieces the finder can use with hold.
+    //
+    // Layout (native byte order):
+    //   FileHeader, then for each section: SectionHeader, entries
+    //   Entry: status (1 byte), then `maxDepth` operations of 4 bytes (piece type, rotate type, x, y)
+    //
+    // A section of n pieces has 7^n entries: 6 pieces take 2.5MB for a 2-line PC, 11 pieces take 81GB for a 4-line PC.
+    class PCDatabase {
+    public:
+        static constexpr uint32_t kVersion = 1;
+
+        enum Status : uint8_t {
+            Unknown = 0,
+            NoSolution = 1,
+            Solved = 2,
+        };
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t game;
+            uint32_t numOfSections;
+            uint32_t reserved;
+        };
+
+        struct SectionHeader {
+            uint64_t boards[4];
+            uint64_t numOfEntries;
+            uint8_t maxLine;
+            uint8_t maxDepth;
+            uint8_t numOfPieces;
+            uint8_t searchType;
+            uint8_t holdEmpty;
+            uint8_t leastLineClears;
+            uint8_t initB2b;
+            uint8_t initCombo;
+        };
+
+        // The search parameters that decide which solution is the best
+        struct Parameters {
+            int searchType;
+            bool holdEmpty;
+            bool leastLineClears;
+            bool initB2b;
+            int initCombo;
+        };
+
+        PCDatabase() = default;
+
+        PCDatabase(const PCDatabase &) = delete;
+
+        PCDatabase &operator=(const PCDatabase &) = delete;
+
+        ~PCDatabase() {
+            close();
+        }
+
+        // Map the file. `game` must match the one it was generated for.
+        // Must not be called while searching.
+        bool open(const std::string &path, uint32_t game);
+
+        void close();
+
+        [[nodiscard]] bool opened() const {
+            return data_ != nullptr;
+        }
+
+        // NoSolution if a section proves that the pieces cannot make a perfect clear.
+        // Solved if a section generated with the same parameters has the best solution, which is copied to `solution`.
+        // Unknown otherwise, then the finder has to search.
+        Status find(
+                const core::Field &field, int maxLine, const std::vector<core::PieceType> &pieces,
+                const Parameters &parameters, Solution &solution
+        ) const;
+
+        static uint64_t hash(const std::vector<core::PieceType> &pieces, int numOfPieces) {
+            uint64_t hash = 0;
+            for (int index = 0; index < numOfPieces; ++index) {
+                hash = hash * 7 + pieces[index];
+            }
+            return hash;
+        }
+
+        static uint64_t numOfQueues(int numOfPieces) {
+            uint64_t count = 1;
+            for (int index = 0; index < numOfPieces; ++index) {
+                count *= 7;
+            }
+            return count;
+        }
+
+        // Search every queue of `numOfPieces` pieces with `search` and append the results as a new section.
+        // `numOfPieces` is `maxDepth + 1` for queues with a piece left over to hold, or `maxDepth` for queues used up.
+        // `search(pieces, solution)` stores the best solution, or leaves it empty if there is none.
+        // It returns false if the search was cancelled; then the section is dropped.
+        // The file is created if it does not exist. It must not be mapped while generating.
+        template<class Search>
+        static bool generate(
+                const std::string &path, uint32_t game, const core::Field &field, int maxLine,
+                int numOfPieces, const Parameters &parameters, Search search
+        ) {
+            int numOfSpace = core::FIELD_WIDTH * maxLine - field.getNumOfBlocks();
+            if (numOfSpace <= 0 || numOfSpace % 4 != 0 || 11 < numOfPieces) {
+                return false;
+            }
+
+            int maxDepth = numOfSpace / 4;
+            if (numOfPieces != maxDepth && numOfPieces != maxDepth + 1) {
+                return false;
+            }
+
+            auto header = SectionHeader{
+                    {field.xBoardLow, field.xBoardMidLow, field.xBoardMidHigh, field.xBoardHigh},
+                    numOfQueues(numOfPieces),
+                    static_cast<uint8_t>(maxLine),
+                    static_cast<uint8_t>(maxDepth),
+                    static_cast<uint8_t>(numOfPieces),
+                    static_cast<uint8_t>(parameters.searchType),
+                    parameters.holdEmpty,
+                    parameters.leastLineClears,
+                    parameters.initB2b,
+                    static_cast<uint8_t>(parameters.initCombo),
+            };
+
+            auto file = beginSection(path, game, header);
+            if (file == nullptr) {
+                return false;
+            }
+
+            auto pieces = std::vector<core::PieceType>(numOfPieces);
+            auto solution = Solution{};
+            auto entry = std::vector<uint8_t>(entrySize(header));
+            bool written = true;
+
+            for (uint64_t queue = 0; queue < header.numOfEntries && written; ++queue) {
+                auto rest = queue;
+                for (int index = numOfPieces - 1; 0 <= index; --index) {
+                    pieces[index] = static_cast<core::PieceType>(rest % 7);
+                    rest /= 7;
+                }
+
+                solution.clear();
+                if (!search(pieces, solution)) {
+                    written = false;
+                    break;
+                }
+
+                toEntry(solution, entry);
+                written = std::fwrite(entry.data(), 1, entry.size(), file) == entry.size();
+            }
+
+            return endSection(file, written);
+        }
+
+    private:
+        struct Section {
+            SectionHeader header;
+            const uint8_t *entries;
+        };
+
+        static size_t entrySize(const SectionHeader &header) {
+            return 1 + 4 * static_cast<size_t>(header.maxDepth);
+        }
+
+        static void toEntry(const Solution &solution, std::vector<uint8_t> &entry);
+
+        static FILE *beginSection(const std::string &path, uint32_t game, const SectionHeader &header);
+
+        static bool endSection(FILE *file, bool written);
+
+        const uint8_t *data_ = nullptr;
+        size_t size_ = 0;
+        std::vector<Section> sections_{};
+
+        // Platform handles of the mapping
+        void *file_ = nullptr;
+        void *mapping_ = nullptr;
+    };
+}
+
+#endif //FINDER_PC_DATABASE_HPP
@@ -21,10 +21,27 @@ namespace finder {
         return 0;
     }
 
+    // Bound layout: 1 bit to mark that a record exists, 31 bits of attack, 32 bits of inverted softdrop count.
+    // A stronger record is a larger value.
+    uint64_t packBound(int attack, int softdropCount) {
+        assert(0 <= attack && 0 <= softdropCount);
+        return 1ULL << 63U
+               | static_cast<uint64_t>(attack) << 32U
+               | static_cast<uint64_t>(UINT32_MAX - static_cast<uint32_t>(softdropCount));
+    }
+
+    int extractBoundAttack(uint64_t bound) {
+        return static_cast<int>((bound >> 32U) & 0x7fffffffU);
+    }
+
+    int extractBoundSoftdropCount(uint64_t bound) {
+        return static_cast<int>(UINT32_MAX - static_cast<uint32_t>(bound & UINT32_MAX));
+    }
+
     // For fast search
     void Recorder<FastCandidate, FastRecord>::clear() {
         best_ = FastRecord{
-                std::vector<Operation>{},
+                Solution{},
                 core::PieceType::Empty,
                 INT_MAX,
                 INT_MAX,
@@ -68,6 +85,22 @@ namespace finder {
         return best_.softdropCount < current.softdropCount;
     }
 
+    uint64_t Recorder<FastCandidate, FastRecord>::bound() const {
+        if (best_.solution.empty() || best_.holdPriority == 0) {
+            return 0;
+        }
+
+        return packBound(0, best_.softdropCount);
+    }
+
+    bool Recorder<FastCandidate, FastRecord>::isWorseThanBound(uint64_t bound, const FastCandidate &current) {
+        if (bound == 0) {
+            return false;
+        }
+
+        return extractBoundSoftdropCount(bound) < current.softdropCount;
+    }
+
 	bool shouldUpdateFrames(
 		const FastRecord& oldRecord, const FastCandidate& newRecord
 	) {
@@ -137,7 +170,7 @@ namespace finder {
     // For T-Spin search
     void Recorder<TSpinCandidate, TSpinRecord>::clear() {
         best_ = TSpinRecord{
-                std::vector<Operation>{},
+                Solution{},
                 core::PieceType::Empty,
                 INT_MAX,
                 INT_MAX,
@@ -192,6 +225,27 @@ namespace finder {
         return false;
     }
 
+    uint64_t Recorder<TSpinCandidate, TSpinRecord>::bound() const {
+        if (best_.solution.empty() || best_.holdPriority == 0) {
+            return 0;
+        }
+
+        return packBound(best_.tSpinAttack, best_.softdropCount);
+    }
+
+    bool Recorder<TSpinCandidate, TSpinRecord>::isWorseThanBound(uint64_t bound, const TSpinCandidate &current) {
+        if (bound == 0 || current.leftNumOfT != 0) {
+            return false;
+        }
+
+        int tSpinAttack = extractBoundAttack(bound);
+        if (current.tSpinAttack != tSpinAttack) {
+            return current.tSpinAttack < tSpinAttack;
+        }
+
+        return extractBoundSoftdropCount(bound) < current.softdropCount;
+    }
+
 	bool shouldUpdateFrames(
 		const TSpinRecord& oldRecord, const TSpinCandidate& newRecord
 	) {
@@ -269,7 +323,7 @@ namespace finder {
     // For all spins search
     void Recorder<AllSpinsCandidate, AllSpinsRecord>::clear() {
         best_ = AllSpinsRecord{
-                std::vector<Operation>{},
+                Solution{},
                 core::PieceType::Empty,
                 INT_MAX,
                 INT_MAX,
@@ -312,6 +366,14 @@ namespace finder {
         return false;
     }
 
+    uint64_t Recorder<AllSpinsCandidate, AllSpinsRecord>::bound() const {
+        return 0;
+    }
+
+    bool Recorder<AllSpinsCandidate, AllSpinsRecord>::isWorseThanBound(uint64_t bound, const AllSpinsCandidate &current) {
+        return false;
+    }
+
 	bool shouldUpdateFrames(
 		const AllSpinsRecord& oldRecord, const AllSpinsCandidate& newRecord
 	) {
@@ -388,7 +450,7 @@ namespace finder {
     // For TETR.IO Season 2 search
     void Recorder<TETRIOS2Candidate, TETRIOS2Record>::clear() {
         best_ = TETRIOS2Record{
-                std::vector<Operation>{},
+                Solution{},
                 core::PieceType::Empty,
                 INT_MAX,
                 INT_MAX,
@@ -433,6 +495,14 @@ namespace finder {
         return false;
     }
 
+    uint64_t Recorder<TETRIOS2Candidate, TETRIOS2Record>::bound() const {
+        return 0;
+    }
+
+    bool Recorder<TETRIOS2Candidate, TETRIOS2Record>::isWorseThanBound(uint64_t bound, const TETRIOS2Candidate &current) {
+        return false;
+    }
+
 	bool shouldUpdateFrames(
 		const TETRIOS2Record& oldRecord, const TETRIOS2Candidate& newRecord
 	) {
@@ -7,14 +7,30 @@
 #include "spins.hpp"
 #include "two_lines_pc.hpp"
 #include "frames.hpp"
+#include "transposition_table.hpp"
+#include "shared_bound.hpp"
+#include "splitter.hpp"
+#include "cancellation.hpp"
+#include "feasibility.hpp"
+#include "search_arena.hpp"
+#include "move_history.hpp"
+#include "search_stats.hpp"
+#include "top_k_recorder.hpp"
+
+#include "../callback.hpp"
 
 #include "../core/piece.hpp"
 #include "../core/moves.hpp"
+#include "../core/small_field.hpp"
 #include "../core/types.hpp"
 
 namespace finder {
     namespace {
-        inline bool validate(const core::Field &field, int maxLine) {
+        inline bool isValidField(const core::Field &field, int maxLine) {
+            if (maxLine <= core::small_field::MAX_HEIGHT) {
+                return core::small_field::validate(field, maxLine);
+            }
+
             int sum = maxLine - field.getBlockOnX(0, maxLine);
             for (int x = 1; x < core::FIELD_WIDTH; x++) {
                 int emptyCountInColumn = maxLine - field.getBlockOnX(x, maxLine);
@@ -30,23 +46,76 @@ namespace finder {
             return sum % 4 == 0;
         }
 
+        // Whether the empty cells may still be filled with pieces. Rejections are counted in `SearchCounters`.
+        inline bool validate(const core::Field &field, int maxLine) {
+            if (isValidField(field, maxLine)) {
+                return true;
+            }
+
+            SearchCounters::local().rejected();
+            return false;
+        }
+
+        template<class M>
+        inline void generateMoves(
+                M &moveGenerator, std::vector<core::Move> &moves, const core::Field &field, core::PieceType pieceType,
+                int leftLine
+        ) {
+            PhaseTimer timer(SearchPhase::MoveGeneration);
+
+            auto begin = moves.size();
+            moveGenerator.search(moves, field, pieceType, leftLine);
+            SearchCounters::local().moves(moves.size() - begin);
+        }
+
         inline int calcScore(const core::Field &field, const bool harddrop) {
-            return field.getNumOfHoles() * 10 + !harddrop;
+            int numOfHoles = core::small_field::isSmall(field)
+                             ? core::small_field::getNumOfHoles(field)
+                             : field.getNumOfHoles();
+            return numOfHoles * 10 + !harddrop;
+        }
+
+        // Moves are below the lines left, so the field stays in the lower 6 rows once 6 lines or fewer are left.
+        // The initial field may still be taller than the lines to clear.
+        inline bool isSmallField(const core::Field &field, int leftLine) {
+            return leftLine <= core::small_field::MAX_HEIGHT && core::small_field::isSmall(field);
+        }
+
+        // Puts the piece and returns the number of cleared lines
+        inline int putAndClearLine(core::Field &field, const core::Blocks &blocks, const core::Move &move, int leftLine) {
+            if (isSmallField(field, leftLine)) {
+                core::small_field::put(field, blocks, move.x, move.y);
+                return core::small_field::clearLineReturnNum(field);
+            }
+
+            field.put(blocks, move.x, move.y);
+            return field.clearLineReturnNum();
         }
 
         inline void toScoredMove(
                 const std::vector<core::Move> &moves,
-                const core::Factory &factory, const core::PieceType pieceType, const core::Field &field,
-                std::vector<core::ScoredMove> &scoredMoves
+                const core::Factory &factory, const core::PieceType pieceType, const core::Field &field, int leftLine,
+                std::vector<core::ScoredMove> &scoredMoves, const MoveHistory &history, int depth
         ) {
+            PhaseTimer timer(SearchPhase::Ordering);
+
+            auto small = isSmallField(field, leftLine);
+
             for (const auto &move : moves) {
                 auto &blocks = factory.get(pieceType, move.rotateType);
 
                 auto freeze = core::Field(field);
-                freeze.put(blocks, move.x, move.y);
-
-                int score = calcScore(freeze, move.harddrop);
-                int numCleared = freeze.clearLineReturnNum();
+                int score;
+                int numCleared;
+                if (small) {
+                    core::small_field::put(freeze, blocks, move.x, move.y);
+                    score = core::small_field::getNumOfHoles(freeze) * 10 + !move.harddrop;
+                    numCleared = core::small_field::clearLineReturnNum(freeze);
+                } else {
+                    freeze.put(blocks, move.x, move.y);
+                    score = calcScore(freeze, move.harddrop);
+                    numCleared = freeze.clearLineReturnNum();
+                }
 
                 scoredMoves.push_back({
                                               freeze,
@@ -56,11 +125,33 @@ namespace finder {
                                       });
             }
 
+            // Ties of the static score are broken by the history
             std::sort(scoredMoves.begin(), scoredMoves.end(),
-                      [](const core::ScoredMove &first, const core::ScoredMove &second) {
-                          return first.score < second.score;
+                      [&](const core::ScoredMove &first, const core::ScoredMove &second) {
+                          if (first.score != second.score) {
+                              return first.score < second.score;
+                          }
+                          return history.rank(pieceType, second.move, depth) < history.rank(pieceType, first.move, depth);
                       });
         }
+
+        // Candidate states other than the field and the queue position that change which moves are legal below it
+        inline uint64_t extraStateOf(const FastCandidate &candidate) {
+            return 0;
+        }
+
+        inline uint64_t extraStateOf(const TSpinCandidate &candidate) {
+            return 0;
+        }
+
+        inline uint64_t extraStateOf(const AllSpinsCandidate &candidate) {
+            return 0;
+        }
+
+        inline uint64_t extraStateOf(const TETRIOS2Candidate &candidate) {
+            // Minis count as spins only with B2B, and the first clear of a two-line PC must not be a double
+            return (0 < candidate.b2b ? 1U : 0U) | (candidate.lineClearCount == 0 ? 2U : 0U);
+        }
     }
 
     enum SearchTypes {
@@ -81,20 +172,30 @@ namespace finder {
     class PCFindRunner {
     public:
         PCFindRunner(
-                const core::Factory &factory, M &moveGenerator, core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable
-        ) : mover(Mover<Allow180, AllowSoftdropTap, M, C>(factory, moveGenerator, reachable)), recorder(Recorder<C, R>()) {}
+                const core::Factory &factory, M &moveGenerator, core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable,
+                CancellationToken &token,
+                TranspositionTable *table = nullptr, SharedBound *sharedBound = nullptr, Splitter<C> *splitter = nullptr,
+                const SolutionListener *listener = nullptr
+        ) : mover(Mover<Allow180, AllowSoftdropTap, M, C>(factory, moveGenerator, reachable)), recorder(Recorder<C, R>()),
+            token(token), table(table != nullptr && table->enabled() ? table : nullptr), sharedBound(sharedBound),
+            splitter(splitter), listener(listener != nullptr && *listener ? listener : nullptr),
+            moveHistory(MoveHistory::local()), counters(SearchCounters::local()) {}
 
         PCFindRunner(
                 PCFindRunner &&rhs
-        ) : mover(std::move(rhs.mover)), recorder(std::move(rhs.recorder)) {}
+        ) : mover(std::move(rhs.mover)), recorder(std::move(rhs.recorder)), topK(std::move(rhs.topK)), token(rhs.token),
+            table(rhs.table), sharedBound(rhs.sharedBound), splitter(rhs.splitter), listener(rhs.listener),
+            moveHistory(rhs.moveHistory), counters(rhs.counters) {}
 
         Solution run(const Configure &configure, const core::Field &field, const C &candidate) {
             auto best = runRecord(configure, field, candidate);
-            return best.solution.empty() ? kNoSolution : std::vector<Operation>(best.solution);
+            return best.solution;
         }
 
         R runRecord(const Configure &configure, const core::Field &field, const C &candidate) {
             recorder.clear();
+            topK = TopKRecorder<C, R>(configure.topK);
+            moveHistory.clear();
 
             // Initialize solution
             Solution solution(configure.maxDepth);
@@ -103,13 +204,15 @@ namespace finder {
             });
 
             // Execute
-            search(configure, field, candidate, solution);
+            searchRoot(configure, field, candidate, solution);
 
             return recorder.best();
         }
 
         R runRecord(const Configure &configure, const core::Field &field, const C &candidate, const R &initRecord) {
             recorder.update(initRecord);
+            topK = TopKRecorder<C, R>(configure.topK);
+            moveHistory.clear();
 
             // Initialize solution
             Solution solution(configure.maxDepth);
@@ -118,16 +221,188 @@ namespace finder {
             });
 
             // Execute
-            search(configure, field, candidate, solution);
+            searchRoot(configure, field, candidate, solution);
+
+            return recorder.best();
+        }
+
+        // Search a subtree in the middle of the tree. The operations in `solution` before `candidate.depth` are kept.
+        R runRecord(const Configure &configure, const core::Field &field, const C &candidate, Solution &solution) {
+            recorder.clear();
+            topK = TopKRecorder<C, R>(configure.topK);
+            moveHistory.age();
+
+            searchRoot(configure, field, candidate, solution);
+
+            return recorder.best();
+        }
+
+        R runRecord(
+                const Configure &configure, const core::Field &field, const C &candidate, const R &initRecord,
+                Solution &solution
+        ) {
+            recorder.update(initRecord);
+            topK = TopKRecorder<C, R>(configure.topK);
+            moveHistory.age();
+
+            searchRoot(configure, field, candidate, solution);
 
             return recorder.best();
         }
 
         void search(const Configure &configure, const core::Field &field, const C &candidate, Solution &solution) {
-            if (Abort() || recorder.isWorseThanBest(configure.leastLineClears, candidate)) {
+            counters.node(candidate.depth);
+
+            if (cancelled() || isPruned(configure, candidate)) {
+                numOfCutoffs += 1;
+                return;
+            }
+
+            // The remaining pieces cannot fill the empty cells. It is not a cutoff: the state is dead for any record.
+            if (!Feasibility::check(
+                    configure, field, candidate.leftLine, candidate.currentIndex, candidate.holdIndex, candidate.depth
+            )) {
                 return;
             }
 
+            // Hand the subtree over to an idle worker. It is not explored here, so this state must not be marked dead.
+            if (splitter != nullptr && rootDepth < candidate.depth
+                && Splitter<C>::kMinSplitDepth <= configure.maxDepth - candidate.depth && splitter->hungry() && splitter->split(field, candidate, solution)) {
+                numOfCutoffs += 1;
+                return;
+            }
+
+            // Skip the states already known that no perfect clear exists below them
+            uint64_t key = 0;
+            if (table != nullptr) {
+                key = table->key(
+                        field, candidate.currentIndex, candidate.holdIndex, candidate.leftLine, extraStateOf(candidate)
+                );
+                if (table->isDead(key)) {
+                    return;
+                }
+            }
+
+            auto numOfSolutionsBefore = numOfSolutions;
+            auto numOfCutoffsBefore = numOfCutoffs;
+
+            searchChildren(configure, field, candidate, solution);
+
+            // Record only fully explored subtrees: pruned or aborted ones may still contain perfect clears
+            if (table != nullptr && numOfSolutions == numOfSolutionsBefore && numOfCutoffs == numOfCutoffsBefore) {
+                table->markDead(key);
+            }
+        }
+
+        void accept(const Configure &configure, const C &current, const Solution &solution) {
+            numOfSolutions += 1;
+
+            if (listener != nullptr) {
+                (*listener)(solution);
+            }
+
+            bool improved = recorder.shouldUpdate(configure, current);
+            moveHistory.reward(solution, current.depth, improved);
+
+            if (improved) {
+                recorder.update(configure, current, solution);
+                counters.updated();
+
+                // Let the other tasks prune against it right away
+                if (sharedBound != nullptr && configure.topK <= 1) {
+                    sharedBound->publish(recorder.bound());
+                }
+            }
+
+            // Only the K-th best can prune while K are kept. Publishing 0 prunes nothing, but marks the first solution.
+            if (1 < configure.topK && topK.add(configure, current, solution) && sharedBound != nullptr) {
+                sharedBound->publish(topK.full() ? topK.worst().bound() : 0);
+            }
+        }
+
+        [[nodiscard]] const MoveHistory &history() const {
+            return moveHistory;
+        }
+
+        // The best distinct solutions of the last run, if `Configure::topK` is above 1
+        [[nodiscard]] const TopKRecorder<C, R> &records() const {
+            return topK;
+        }
+
+    private:
+        // Number of nodes between the checks of the abort callback and the deadline
+        static constexpr int kPollInterval = 256;
+
+        Mover<Allow180, AllowSoftdropTap, M, C> mover;
+        Recorder<C, R> recorder;
+        TopKRecorder<C, R> topK;
+        CancellationToken &token;
+        TranspositionTable *table;
+        SharedBound *sharedBound;
+        Splitter<C> *splitter;
+        const SolutionListener *listener;
+        MoveHistory &moveHistory;
+        SearchCounters &counters;
+
+        // Depth of the state the search started from. It is never handed over.
+        int rootDepth = 0;
+
+        int nodesUntilPoll = 0;
+
+        // The abort callback may be a call into managed code, so it is polled only once in a while
+        bool cancelled() {
+            if (--nodesUntilPoll <= 0) {
+                nodesUntilPoll = kPollInterval;
+
+                if (Abort != nullptr && Abort()) {
+                    token.cancelAll();
+                }
+
+                return token.poll();
+            }
+
+            return token.cancelled();
+        }
+
+        // Number of perfect clears reached and subtrees cut off, used to detect dead states
+        uint64_t numOfSolutions = 0;
+        uint64_t numOfCutoffs = 0;
+
+        // Worse than the best, or than the K-th best once K are kept
+        bool isWorseThanKept(const Configure &configure, const C &candidate) const {
+            if (1 < configure.topK) {
+                return topK.full() && topK.worst().isWorseThanBest(configure.leastLineClears, candidate);
+            }
+
+            return recorder.isWorseThanBest(configure.leastLineClears, candidate);
+        }
+
+        bool isWorseThanShared(const C &candidate) const {
+            return sharedBound != nullptr && Recorder<C, R>::isWorseThanBound(sharedBound->load(), candidate);
+        }
+
+        bool isPruned(const Configure &configure, const C &candidate) {
+            if (isWorseThanKept(configure, candidate)) {
+                counters.pruned(false);
+                return true;
+            }
+
+            if (isWorseThanShared(candidate)) {
+                counters.pruned(true);
+                return true;
+            }
+
+            return false;
+        }
+
+        void searchRoot(const Configure &configure, const core::Field &field, const C &candidate, Solution &solution) {
+            PhaseTimer timer(SearchPhase::Search);
+
+            rootDepth = candidate.depth;
+            search(configure, field, candidate, solution);
+        }
+
+        void searchChildren(const Configure &configure, const core::Field &field, const C &candidate, Solution &solution) {
             auto depth = candidate.depth;
 
             auto &pieces = configure.pieces;
@@ -154,7 +429,9 @@ namespace finder {
                 );
             }
 
-			if (!configure.holdAllowed) return;
+            if (!configure.holdAllowed) {
+                return;
+            }
 
             if (0 <= holdIndex) {
                 assert(holdIndex < pieces.size());
@@ -190,16 +467,6 @@ namespace finder {
                 }
             }
         }
-
-        void accept(const Configure &configure, const C &current, const Solution &solution) {
-            if (recorder.shouldUpdate(configure, current)) {
-                recorder.update(configure, current, solution);
-            }
-        }
-
-    private:
-        Mover<Allow180, AllowSoftdropTap, M, C> mover;
-        Recorder<C, R> recorder;
     };
 
     // Mover implementations
@@ -229,16 +496,14 @@ namespace finder {
             auto lastDepth = candidate.depth == configure.maxDepth - 1;
             auto nextLeftNumOfT = pieceType == core::PieceType::T ? candidate.leftNumOfT - 1 : candidate.leftNumOfT;
 
-            moveGenerator.search(moves, field, pieceType, candidate.leftLine);
+            generateMoves(moveGenerator, moves, field, pieceType, candidate.leftLine);
 
             if (configure.fastSearchStartDepth <= candidate.depth) {
                 for (const auto &move : moves) {
                     auto &blocks = factory.get(pieceType, move.rotateType);
 
                     auto freeze = core::Field(field);
-                    freeze.put(blocks, move.x, move.y);
-
-                    int numCleared = freeze.clearLineReturnNum();
+                    int numCleared = putAndClearLine(freeze, blocks, move, candidate.leftLine);
 
                     auto &operation = solution[candidate.depth];
                     operation.pieceType = pieceType;
@@ -246,7 +511,7 @@ namespace finder {
                     operation.x = move.x;
                     operation.y = move.y;
 
-                    int tSpinAttack = !lastDepth ? getAttackIfTSpin<Allow180, AllowSoftdropTap>(
+                    int tSpinAttack = !lastDepth ? getAttackIfTSpin<Allow180, AllowSoftdropTap, M>(
                             moveGenerator, reachable, factory, field, pieceType, move, numCleared, candidate.b2b
                     ) : 0;
 
@@ -287,7 +552,10 @@ namespace finder {
                     finder->search(configure, freeze, nextCandidate, solution);
                 }
             } else {
-                toScoredMove(moves, factory, pieceType, field, scoredMoves);
+                toScoredMove(
+                        moves, factory, pieceType, field, candidate.leftLine, scoredMoves,
+                        finder->history(), candidate.depth
+                );
 
                 for (const auto &s : scoredMoves) {
                     auto &operation = solution[candidate.depth];
@@ -296,7 +564,7 @@ namespace finder {
                     operation.x = s.move.x;
                     operation.y = s.move.y;
 
-                    int tSpinAttack = !lastDepth ? getAttackIfTSpin<Allow180, AllowSoftdropTap>(
+                    int tSpinAttack = !lastDepth ? getAttackIfTSpin<Allow180, AllowSoftdropTap, M>(
                             moveGenerator, reachable, factory, field, pieceType, s.move, s.numCleared, candidate.b2b
                     ) : 0;
 
@@ -355,15 +623,13 @@ namespace finder {
 
             auto nextLeftNumOfT = pieceType == core::PieceType::T ? candidate.leftNumOfT - 1 : candidate.leftNumOfT;
 
-            moveGenerator.search(moves, field, pieceType, candidate.leftLine);
+            generateMoves(moveGenerator, moves, field, pieceType, candidate.leftLine);
 
             for (const auto &move : moves) {
                 auto &blocks = factory.get(pieceType, move.rotateType);
 
                 auto freeze = core::Field(field);
-                freeze.put(blocks, move.x, move.y);
-
-                int numCleared = freeze.clearLineReturnNum();
+                int numCleared = putAndClearLine(freeze, blocks, move, candidate.leftLine);
 
 				auto operation = Operation{
 					pieceType,
@@ -415,7 +681,7 @@ namespace finder {
     private:
         const core::Factory &factory;
         M &moveGenerator;
-        core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> reachable;
+        core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable;
     };
 
     template<bool Allow180, bool AllowSoftdropTap, class M>
@@ -441,16 +707,14 @@ namespace finder {
         ) {
             assert(0 < candidate.leftLine);
 
-            moveGenerator.search(moves, field, pieceType, candidate.leftLine);
+            generateMoves(moveGenerator, moves, field, pieceType, candidate.leftLine);
 
             if (configure.fastSearchStartDepth <= candidate.depth) {
                 for (const auto &move : moves) {
                     auto &blocks = factory.get(pieceType, move.rotateType);
 
                     auto freeze = core::Field(field);
-                    freeze.put(blocks, move.x, move.y);
-
-                    int numCleared = freeze.clearLineReturnNum();
+                    int numCleared = putAndClearLine(freeze, blocks, move, candidate.leftLine);
 
                     auto &operation = solution[candidate.depth];
                     operation.pieceType = pieceType;
@@ -493,7 +757,10 @@ namespace finder {
                     finder->search(configure, freeze, nextCandidate, solution);
                 }
             } else {
-                toScoredMove(moves, factory, pieceType, field, scoredMoves);
+                toScoredMove(
+                        moves, factory, pieceType, field, candidate.leftLine, scoredMoves,
+                        finder->history(), candidate.depth
+                );
 
                 for (const auto &s : scoredMoves) {
                     auto &operation = solution[candidate.depth];
@@ -553,15 +820,13 @@ namespace finder {
         ) {
             assert(0 < candidate.leftLine);
 
-            moveGenerator.search(moves, field, pieceType, candidate.leftLine);
+            generateMoves(moveGenerator, moves, field, pieceType, candidate.leftLine);
 
             for (const auto &move : moves) {
                 auto &blocks = factory.get(pieceType, move.rotateType);
 
                 auto freeze = core::Field(field);
-                freeze.put(blocks, move.x, move.y);
-
-                int numCleared = freeze.clearLineReturnNum();
+                int numCleared = putAndClearLine(freeze, blocks, move, candidate.leftLine);
 
 				auto operation = Operation{
 					pieceType,
@@ -607,7 +872,7 @@ namespace finder {
     private:
         const core::Factory &factory;
         M &moveGenerator;
-        core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> reachable;
+        core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable;
     };
 
     template<bool Allow180, bool AllowSoftdropTap, class M>
@@ -633,9 +898,9 @@ namespace finder {
         ) {
             assert(0 < candidate.leftLine);
 
-            auto getAttack = configure.alwaysRegularAttack ? getAttackIfAllSpins<true, Allow180, AllowSoftdropTap> : getAttackIfAllSpins<false, Allow180, AllowSoftdropTap>;
+            auto getAttack = configure.alwaysRegularAttack ? getAttackIfAllSpins<true, Allow180, AllowSoftdropTap, M> : getAttackIfAllSpins<false, Allow180, AllowSoftdropTap, M>;
 
-            moveGenerator.search(moves, field, pieceType, candidate.leftLine);
+            generateMoves(moveGenerator, moves, field, pieceType, candidate.leftLine);
 
             auto lastDepth = candidate.depth == configure.maxDepth - 1;
 
@@ -644,9 +909,7 @@ namespace finder {
                     auto &blocks = factory.get(pieceType, move.rotateType);
 
                     auto freeze = core::Field(field);
-                    freeze.put(blocks, move.x, move.y);
-
-                    int numCleared = freeze.clearLineReturnNum();
+                    int numCleared = putAndClearLine(freeze, blocks, move, candidate.leftLine);
 
                     auto &operation = solution[candidate.depth];
                     operation.pieceType = pieceType;
@@ -701,7 +964,10 @@ namespace finder {
                     finder->search(configure, freeze, nextCandidate, solution);
                 }
             } else {
-                toScoredMove(moves, factory, pieceType, field, scoredMoves);
+                toScoredMove(
+                        moves, factory, pieceType, field, candidate.leftLine, scoredMoves,
+                        finder->history(), candidate.depth
+                );
 
                 for (const auto &s : scoredMoves) {
                     auto &operation = solution[candidate.depth];
@@ -773,9 +1039,9 @@ namespace finder {
         ) {
             assert(0 < candidate.leftLine);
 
-            auto getAttack = alwaysRegularAttack ? getAttackIfAllSpins<true, Allow180, AllowSoftdropTap> : getAttackIfAllSpins<false, Allow180, AllowSoftdropTap>;
+            auto getAttack = alwaysRegularAttack ? getAttackIfAllSpins<true, Allow180, AllowSoftdropTap, M> : getAttackIfAllSpins<false, Allow180, AllowSoftdropTap, M>;
 
-            moveGenerator.search(moves, field, pieceType, candidate.leftLine);
+            generateMoves(moveGenerator, moves, field, pieceType, candidate.leftLine);
 
             auto lastDepth = candidate.depth == maxDepth - 1;
 
@@ -783,9 +1049,7 @@ namespace finder {
                 auto &blocks = factory.get(pieceType, move.rotateType);
 
                 auto freeze = core::Field(field);
-                freeze.put(blocks, move.x, move.y);
-
-                int numCleared = freeze.clearLineReturnNum();
+                int numCleared = putAndClearLine(freeze, blocks, move, candidate.leftLine);
 
 				auto operation = Operation{
 					pieceType,
@@ -843,7 +1107,7 @@ namespace finder {
     private:
         const core::Factory &factory;
         M &moveGenerator;
-        core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> reachable;
+        core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable;
     };
     
     template<bool Allow180, bool AllowSoftdropTap, class M>
@@ -869,9 +1133,9 @@ namespace finder {
         ) {
             assert(0 < candidate.leftLine);
 
-            auto getAttack = configure.alwaysRegularAttack ? getAttackIfAllSpins<true, Allow180, AllowSoftdropTap> : getAttackIfAllSpins<false, Allow180, AllowSoftdropTap>;
+            auto getAttack = configure.alwaysRegularAttack ? getAttackIfAllSpins<true, Allow180, AllowSoftdropTap, M> : getAttackIfAllSpins<false, Allow180, AllowSoftdropTap, M>;
 
-            moveGenerator.search(moves, field, pieceType, candidate.leftLine);
+            generateMoves(moveGenerator, moves, field, pieceType, candidate.leftLine);
 
             auto lastDepth = candidate.depth == configure.maxDepth - 1;
 
@@ -880,9 +1144,7 @@ namespace finder {
                     auto &blocks = factory.get(pieceType, move.rotateType);
 
                     auto freeze = core::Field(field);
-                    freeze.put(blocks, move.x, move.y);
-
-                    int numCleared = freeze.clearLineReturnNum();
+                    int numCleared = putAndClearLine(freeze, blocks, move, candidate.leftLine);
 
                     auto &operation = solution[candidate.depth];
                     operation.pieceType = pieceType;
@@ -971,7 +1233,10 @@ namespace finder {
                     finder->search(configure, freeze, nextCandidate, solution);
                 }
             } else {
-                toScoredMove(moves, factory, pieceType, field, scoredMoves);
+                toScoredMove(
+                        moves, factory, pieceType, field, candidate.leftLine, scoredMoves,
+                        finder->history(), candidate.depth
+                );
 
                 for (const auto &s : scoredMoves) {
                     auto &operation = solution[candidate.depth];
@@ -1077,9 +1342,9 @@ namespace finder {
         ) {
             assert(0 < candidate.leftLine);
 
-            auto getAttack = alwaysRegularAttack ? getAttackIfAllSpins<true, Allow180, AllowSoftdropTap> : getAttackIfAllSpins<false, Allow180, AllowSoftdropTap>;
+            auto getAttack = alwaysRegularAttack ? getAttackIfAllSpins<true, Allow180, AllowSoftdropTap, M> : getAttackIfAllSpins<false, Allow180, AllowSoftdropTap, M>;
 
-            moveGenerator.search(moves, field, pieceType, candidate.leftLine);
+            generateMoves(moveGenerator, moves, field, pieceType, candidate.leftLine);
 
             auto lastDepth = candidate.depth == maxDepth - 1;
 
@@ -1087,9 +1352,7 @@ namespace finder {
                 auto &blocks = factory.get(pieceType, move.rotateType);
 
                 auto freeze = core::Field(field);
-                freeze.put(blocks, move.x, move.y);
-
-                int numCleared = freeze.clearLineReturnNum();
+                int numCleared = putAndClearLine(freeze, blocks, move, candidate.leftLine);
 
 				auto operation = Operation{
 					pieceType,
@@ -1181,7 +1444,7 @@ namespace finder {
     private:
         const core::Factory &factory;
         M &moveGenerator;
-        core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> reachable;
+        core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable;
     };
 
     // Recorder defines
@@ -1200,6 +1463,10 @@ namespace finder {
 
         [[nodiscard]] bool shouldUpdate(const Configure &configure, const TSpinCandidate &newRecord) const;
 
+        [[nodiscard]] uint64_t bound() const;
+
+        [[nodiscard]] static bool isWorseThanBound(uint64_t bound, const TSpinCandidate &current);
+
         [[nodiscard]] const TSpinRecord &best() const {
             return best_;
         }
@@ -1223,6 +1490,10 @@ namespace finder {
 
         [[nodiscard]] bool shouldUpdate(const Configure &configure, const FastCandidate &newRecord) const;
 
+        [[nodiscard]] uint64_t bound() const;
+
+        [[nodiscard]] static bool isWorseThanBound(uint64_t bound, const FastCandidate &current);
+
         [[nodiscard]] const FastRecord &best() const {
             return best_;
         }
@@ -1246,6 +1517,10 @@ namespace finder {
 
         [[nodiscard]] bool shouldUpdate(const Configure &configure, const AllSpinsCandidate &newRecord) const;
 
+        [[nodiscard]] uint64_t bound() const;
+
+        [[nodiscard]] static bool isWorseThanBound(uint64_t bound, const AllSpinsCandidate &current);
+
         [[nodiscard]] const AllSpinsRecord &best() const {
             return best_;
         }
@@ -1269,6 +1544,10 @@ namespace finder {
 
         [[nodiscard]] bool shouldUpdate(const Configure& configure, const TETRIOS2Candidate& newRecord) const;
 
+        [[nodiscard]] uint64_t bound() const;
+
+        [[nodiscard]] static bool isWorseThanBound(uint64_t bound, const TETRIOS2Candidate& current);
+
         [[nodiscard]] const TETRIOS2Record& best() const {
             return best_;
         }
@@ -1281,8 +1560,9 @@ namespace finder {
     template<bool Allow180 = false, bool AllowSoftdropTap = true, class M = core::srs::MoveGenerator<Allow180, AllowSoftdropTap>>
     class PerfectClearFinder {
     public:
-        PerfectClearFinder(const core::Factory &factory, M &moveGenerator)
-                : factory(factory), moveGenerator(moveGenerator), reachable(core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap>(factory)) {
+        PerfectClearFinder(const core::Factory &factory, M &moveGenerator, CancellationToken &token)
+                : factory(factory), moveGenerator(moveGenerator), reachable(core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap>(factory)),
+                  token(token) {
         }
 
         // If `alwaysRegularAttack` is true, mini spin is judged as regular attack
@@ -1296,22 +1576,14 @@ namespace finder {
             // Copy field
             auto freeze = core::Field(field);
 
-            // Initialize moves
-            std::vector<std::vector<core::Move>> movePool(maxDepth);
-            for (int index = 0; index < maxDepth; ++index) {
-                movePool[index] = std::vector<core::Move>{};
-            }
-
-            std::vector<std::vector<core::ScoredMove>> scoredMovePool(maxDepth);
-            for (int index = 0; index < maxDepth; ++index) {
-                scoredMovePool[index] = std::vector<core::ScoredMove>{};
-            }
+            // Borrow the move buffers of this thread
+            ArenaLease lease(maxDepth);
 
             // Initialize configure
             const auto configure = Configure{
                     pieces,
-                    movePool,
-                    scoredMovePool,
+                    lease.arena.movePool,
+                    lease.arena.scoredMovePool,
                     maxDepth,
                     fastSearchStartDepth,
                     static_cast<int>(pieces.size()),
@@ -1331,7 +1603,7 @@ namespace finder {
                                                      initCombo, initCombo, 0};
 
                     auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M, FastCandidate, FastRecord>(
-                            factory, moveGenerator, reachable
+                            factory, moveGenerator, reachable, token
                     );
                     return finder.run(configure, freeze, candidate);
                 }
@@ -1349,7 +1621,7 @@ namespace finder {
                                                       initCombo, initCombo, 0, initB2b, leftNumOfT, 0};
 
                     auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M>(
-                            factory, moveGenerator, reachable
+                            factory, moveGenerator, reachable, token
                     );
                     return finder.run(configure, freeze, candidate);
                 }
@@ -1362,7 +1634,7 @@ namespace finder {
                                                          initCombo, initCombo, 0, initB2b, 0};
 
                     auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M, AllSpinsCandidate, AllSpinsRecord>(
-                            factory, moveGenerator, reachable
+                            factory, moveGenerator, reachable, token
                     );
                     return finder.run(configure, freeze, candidate);
                 }
@@ -1375,7 +1647,7 @@ namespace finder {
                                                          initCombo, 0, initB2b? 1 : 0, 0, false, false};
 
                     auto finder = PCFindRunner<Allow180, AllowSoftdropTap, M, TETRIOS2Candidate, TETRIOS2Record>(
-                            factory, moveGenerator, reachable
+                            factory, moveGenerator, reachable, token
                     );
                     return finder.run(configure, freeze, candidate);
                 }
@@ -1393,7 +1665,8 @@ namespace finder {
                 int initCombo, bool initB2b, bool twoLineFollowUp, int numApplyFastSearch
         ) {
             int numOfSpace = core::FIELD_WIDTH * maxLine - field.getNumOfBlocks();
-            if (numOfSpace % 4 != 0) {
+            // A solution holds up to `Solution::kCapacity` pieces
+            if (numOfSpace % 4 != 0 || Solution::kCapacity * 4 < numOfSpace) {
                 return kNoSolution;
             }
 
@@ -1488,13 +1761,15 @@ namespace finder {
         }
 
         void abort() {
-            status.abort();
+            token.cancel();
         }
 
     private:
         const core::Factory &factory;
         M &moveGenerator;
+        // Lent to the runners of each search
         core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> reachable;
+        CancellationToken &token;
     };
 }
 
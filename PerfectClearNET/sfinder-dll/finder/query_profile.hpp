@@ -0,0 +1,247 @@
+#ifndef FINDER_QUERY_PROFILE_HPP
+#define FINDER_QUERY_PROFILE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+#include "cancellation.hpp"
+
+#include "../core/bits.hpp"
+
+namespace finder {
+    enum class QueryPhase {
+        // Reading the field and the queue, and choosing the heights
+        Parse = 0,
+        // Looking the heights up in the database
+        Lookup = 1,
+        // Generating the first moves
+        Premove = 2,
+        // Queueing the tasks of the first moves
+        Dispatch = 3,
+        // Waiting for the tasks, from the last first move queued until all tasks finish
+        Search = 4,
+        // Writing the solution into the output string
+        Format = 5,
+    };
+
+    // Where the wall-clock time of one query went, in nanoseconds.
+    // The phases run one after another on the calling thread, while `queueWait` is summed over the tasks.
+    struct QueryTimes {
+        uint64_t total;
+        uint64_t parse;
+        uint64_t lookup;
+        uint64_t premove;
+        uint64_t dispatch;
+        uint64_t search;
+        uint64_t format;
+        uint64_t queueWait;
+        uint64_t maxQueueWait;
+        uint64_t tasks;
+        uint64_t heights;
+    };
+
+    // Collects the times of the current query. Workers report how long their tasks were queued.
+    class QueryProfile {
+    public:
+        void clear() {
+            for (auto &phase : phases_) {
+                phase.store(0, std::memory_order_relaxed);
+            }
+            queueWait_.store(0, std::memory_order_relaxed);
+            maxQueueWait_.store(0, std::memory_order_relaxed);
+            tasks_.store(0, std::memory_order_relaxed);
+            heights_.store(0, std::memory_order_relaxed);
+        }
+
+        void add(QueryPhase phase, int64_t nanos) {
+            phases_[static_cast<int>(phase)].fetch_add(static_cast<uint64_t>(nanos), std::memory_order_relaxed);
+        }
+
+        // A task started after waiting `nanos` in the queue
+        void started(int64_t nanos) {
+            auto waited = static_cast<uint64_t>(std::max<int64_t>(nanos, 0));
+            queueWait_.fetch_add(waited, std::memory_order_relaxed);
+            tasks_.fetch_add(1, std::memory_order_relaxed);
+
+            auto longest = maxQueueWait_.load(std::memory_order_relaxed);
+            while (longest < waited && !maxQueueWait_.compare_exchange_weak(longest, waited, std::memory_order_relaxed)) {
+            }
+        }
+
+        void searched(int heights) {
+            heights_.fetch_add(static_cast<uint64_t>(heights), std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] QueryTimes times(int64_t total) const {
+            return QueryTimes{
+                    static_cast<uint64_t>(total),
+                    phase(QueryPhase::Parse),
+                    phase(QueryPhase::Lookup),
+                    phase(QueryPhase::Premove),
+                    phase(QueryPhase::Dispatch),
+                    phase(QueryPhase::Search),
+                    phase(QueryPhase::Format),
+                    queueWait_.load(std::memory_order_relaxed),
+                    maxQueueWait_.load(std::memory_order_relaxed),
+                    tasks_.load(std::memory_order_relaxed),
+                    heights_.load(std::memory_order_relaxed),
+            };
+        }
+
+    private:
+        static constexpr int kNumOfPhases = 6;
+
+        [[nodiscard]] uint64_t phase(QueryPhase phase) const {
+            return phases_[static_cast<int>(phase)].load(std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> phases_[kNumOfPhases]{};
+        std::atomic<uint64_t> queueWait_{0};
+        std::atomic<uint64_t> maxQueueWait_{0};
+        std::atomic<uint64_t> tasks_{0};
+        std::atomic<uint64_t> heights_{0};
+    };
+
+    // Adds the time until the end of the scope to a phase of the query
+    class QueryTimer {
+    public:
+        QueryTimer(QueryProfile &profile, QueryPhase phase)
+                : profile_(profile), phase_(phase), start_(CancellationToken::now()) {
+        }
+
+        QueryTimer(const QueryTimer &) = delete;
+
+        QueryTimer &operator=(const QueryTimer &) = delete;
+
+        ~QueryTimer() {
+            profile_.add(phase_, CancellationToken::now() - start_);
+        }
+
+    private:
+        QueryProfile &profile_;
+        QueryPhase phase_;
+        int64_t start_;
+    };
+
+    // Counts latencies in buckets whose width grows with the value, like HdrHistogram:
+    // values below `kSubBuckets` have their own bucket, and each power of two above is split into `kSubBuckets` buckets,
+    // so a bucket is within 1/`kSubBuckets` of its values. Values are in nanoseconds, up to about 18 minutes.
+    class LatencyHistogram {
+    public:
+        static constexpr int kSubBucketBits = 4;
+        static constexpr int kSubBuckets = 1 << kSubBucketBits;
+        static constexpr int kMaxExponent = 40;
+        static constexpr int kNumOfBuckets = (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+        static int bucketOf(uint64_t value) {
+            value = std::min<uint64_t>(value, (1ULL << kMaxExponent) - 1U);
+            if (value < static_cast<uint64_t>(kSubBuckets)) {
+                return static_cast<int>(value);
+            }
+
+            int exponent = core::mostSignificantDigit(value) - 1;
+            auto subBucket = static_cast<int>(value >> static_cast<unsigned>(exponent - kSubBucketBits));
+            return (exponent - kSubBucketBits + 1) * kSubBuckets + subBucket - kSubBuckets;
+        }
+
+        // The largest value counted in the bucket
+        static uint64_t upperBoundOf(int bucket) {
+            if (bucket < kSubBuckets) {
+                return static_cast<uint64_t>(bucket);
+            }
+
+            int exponent = bucket / kSubBuckets + kSubBucketBits - 1;
+            auto shift = static_cast<unsigned>(exponent - kSubBucketBits);
+            auto lower = static_cast<uint64_t>(bucket % kSubBuckets + kSubBuckets) << shift;
+            return lower + (1ULL << shift) - 1U;
+        }
+
+        void clear() {
+            std::fill(std::begin(counts_), std::end(counts_), 0ULL);
+            total_ = 0;
+        }
+
+        void record(uint64_t value) {
+            counts_[bucketOf(value)] += 1;
+            total_ += 1;
+        }
+
+        void add(const LatencyHistogram &other) {
+            for (int bucket = 0; bucket < kNumOfBuckets; ++bucket) {
+                counts_[bucket] += other.counts_[bucket];
+            }
+            total_ += other.total_;
+        }
+
+        [[nodiscard]] uint64_t count(int bucket) const {
+            return counts_[bucket];
+        }
+
+        [[nodiscard]] uint64_t total() const {
+            return total_;
+        }
+
+        // The upper bound of the bucket of the value at `percentile` (0 to 100). 0 if nothing is recorded
+        [[nodiscard]] uint64_t percentile(double percentile) const {
+            if (total_ == 0) {
+                return 0;
+            }
+
+            auto rank = static_cast<uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(total_)));
+            rank = std::clamp<uint64_t>(rank, 1, total_);
+
+            uint64_t seen = 0;
+            for (int bucket = 0; bucket < kNumOfBuckets; ++bucket) {
+                seen += counts_[bucket];
+                if (rank <= seen) {
+                    return upperBoundOf(bucket);
+                }
+            }
+
+            return upperBoundOf(kNumOfBuckets - 1);
+        }
+
+    private:
+        uint64_t counts_[kNumOfBuckets]{};
+        uint64_t total_ = 0;
+    };
+
+    // The latencies of the recent queries: between `kSliceSize` and twice as many of the latest ones.
+    // Two slices take turns, and the older one is dropped when the newer one is full.
+    class RollingLatencyHistogram {
+    public:
+        static constexpr uint64_t kSliceSize = 1024;
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slices_[0].clear();
+            slices_[1].clear();
+        }
+
+        void record(int64_t nanos) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (kSliceSize <= slices_[active_].total()) {
+                active_ ^= 1;
+                slices_[active_].clear();
+            }
+            slices_[active_].record(static_cast<uint64_t>(std::max<int64_t>(nanos, 0)));
+        }
+
+        [[nodiscard]] LatencyHistogram snapshot() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto histogram = slices_[0];
+            histogram.add(slices_[1]);
+            return histogram;
+        }
+
+    private:
+        mutable std::mutex mutex_;
+        LatencyHistogram slices_[2]{};
+        int active_ = 0;
+    };
+}
+
+#endif //FINDER_QUERY_PROFILE_HPP
@@ -0,0 +1,193 @@
+#ifndef FINDER_SEARCH_ARENA_HPP
+#define FINDER_SEARCH_ARENA_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "../core/moves.hpp"
+
+namespace finder {
+    struct ArenaGrowthStats {
+        uint64_t searches;
+        uint64_t growths;
+    };
+
+    // Counts how often the search arena grew: move buffers that grew and task payloads created.
+    // It is not a count of all heap allocations. The futures and callables of the thread pool,
+    // and the vectors built when a search starts, are not counted.
+    // Once the buffers and the pools are warm, a search should not grow the arena however many nodes it visits.
+    class ArenaGrowth {
+    public:
+        static ArenaGrowthStats stats() {
+            return ArenaGrowthStats{
+                    searches_.load(std::memory_order_relaxed),
+                    growths_.load(std::memory_order_relaxed),
+            };
+        }
+
+        static void searched(uint64_t growths) {
+            searches_.fetch_add(1, std::memory_order_relaxed);
+            if (0 < growths) {
+                growths_.fetch_add(growths, std::memory_order_relaxed);
+            }
+        }
+
+        static void grew() {
+            growths_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    private:
+        inline static std::atomic<uint64_t> searches_{0};
+        inline static std::atomic<uint64_t> growths_{0};
+    };
+
+    // The move buffers of each depth, reused by all searches on the same thread.
+    // Buffers keep their capacity between searches, so they stop allocating once they have held the longest move lists.
+    class SearchArena {
+    public:
+        static SearchArena &local() {
+            thread_local SearchArena arena{};
+            return arena;
+        }
+
+        // Takes the buffers for a search of `maxDepth` pieces. A thread runs one search at a time.
+        void acquire(int maxDepth) {
+            assert(!acquired_);
+            acquired_ = true;
+
+            if (movePool.size() < static_cast<size_t>(maxDepth)) {
+                movePool.resize(maxDepth);
+                scoredMovePool.resize(maxDepth);
+                ArenaGrowth::grew();
+            }
+
+            capacities_.resize(movePool.size());
+            for (size_t index = 0; index < movePool.size(); ++index) {
+                capacities_[index] = movePool[index].capacity() + scoredMovePool[index].capacity();
+            }
+        }
+
+        // Counts the buffers that grew during the search
+        void release() {
+            assert(acquired_);
+            acquired_ = false;
+
+            uint64_t grown = 0;
+            for (size_t index = 0; index < movePool.size(); ++index) {
+                if (capacities_[index] != movePool[index].capacity() + scoredMovePool[index].capacity()) {
+                    grown += 1;
+                }
+            }
+
+            ArenaGrowth::searched(grown);
+        }
+
+        std::vector<std::vector<core::Move>> movePool{};
+        std::vector<std::vector<core::ScoredMove>> scoredMovePool{};
+
+    private:
+        std::vector<size_t> capacities_{};
+        bool acquired_ = false;
+    };
+
+    // Holds the arena of the current thread while a search runs
+    class ArenaLease {
+    public:
+        explicit ArenaLease(int maxDepth) : arena(SearchArena::local()) {
+            arena.acquire(maxDepth);
+        }
+
+        ArenaLease(const ArenaLease &) = delete;
+
+        ArenaLease &operator=(const ArenaLease &) = delete;
+
+        ~ArenaLease() {
+            arena.release();
+        }
+
+        SearchArena &arena;
+    };
+
+    // Recycles objects handed over between threads, such as the payloads of queued tasks.
+    // Released objects are kept on a lock-free stack for the next `acquire`, so the pool stops allocating
+    // once it has as many objects as are ever in use at the same time. Only creating an object takes the lock.
+    // Objects live in chunks that are never moved or freed, and the stack links them by index.
+    // The head carries a tag that changes on each update, so that a head popped and pushed back meanwhile fails the exchange.
+    template<class T>
+    class ObjectPool {
+    public:
+        T *acquire() {
+            auto head = head_.load(std::memory_order_acquire);
+            while (index(head) != kNone) {
+                auto next = node(index(head)).next.load(std::memory_order_relaxed);
+                if (head_.compare_exchange_weak(head, link(head, next), std::memory_order_acquire)) {
+                    return &node(index(head));
+                }
+            }
+
+            return create();
+        }
+
+        void release(T *object) {
+            auto &released = static_cast<Node &>(*object);
+
+            auto head = head_.load(std::memory_order_relaxed);
+            do {
+                released.next.store(index(head), std::memory_order_relaxed);
+            } while (!head_.compare_exchange_weak(head, link(head, released.index), std::memory_order_release));
+        }
+
+    private:
+        struct Node : T {
+            std::atomic<uint32_t> next{kNone};
+            uint32_t index = 0;
+        };
+
+        static constexpr uint32_t kNone = UINT32_MAX;
+        static constexpr uint32_t kChunkSize = 256;
+        static constexpr uint32_t kMaxChunks = 4096;
+
+        static uint32_t index(uint64_t head) {
+            return static_cast<uint32_t>(head);
+        }
+
+        // The head that points to `index`, with the next tag
+        static uint64_t link(uint64_t head, uint32_t index) {
+            return ((head >> 32U) + 1U) << 32U | index;
+        }
+
+        Node &node(uint32_t index) {
+            return chunks_[index / kChunkSize].load(std::memory_order_acquire)[index % kChunkSize];
+        }
+
+        T *create() {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            auto position = size_;
+            if (position % kChunkSize == 0) {
+                if (kMaxChunks <= position / kChunkSize) {
+                    throw std::bad_alloc();
+                }
+                chunks_[position / kChunkSize].store(new Node[kChunkSize](), std::memory_order_release);
+            }
+            size_ += 1;
+
+            auto &created = node(position);
+            created.index = position;
+
+            ArenaGrowth::grew();
+            return &created;
+        }
+
+        std::atomic<uint64_t> head_{kNone};
+        std::atomic<Node *> chunks_[kMaxChunks]{};
+        std::mutex mutex_;
+        uint32_t size_ = 0;
+    };
+}
+
+#endif //FINDER_SEARCH_ARENA_HPP
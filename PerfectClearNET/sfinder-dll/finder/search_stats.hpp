@@ -0,0 +1,209 @@
+#ifndef FINDER_SEARCH_STATS_HPP
+#define FINDER_SEARCH_STATS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "thread_registry.hpp"
+#include "types.hpp"
+
+// Define as 0 to compile the counters out of the search
+#ifndef FINDER_SEARCH_STATS
+#define FINDER_SEARCH_STATS 1
+#endif
+
+// Define as 1 to time move generation, ordering and spin checks. It reads the clock twice per node, so only for profiling
+#ifndef FINDER_PHASE_TIMES
+#define FINDER_PHASE_TIMES 0
+#endif
+
+namespace finder {
+    enum class SearchPhase {
+        MoveGeneration = 0,
+        Ordering = 1,
+        SpinCheck = 2,
+        Search = 3,
+    };
+
+    // What the searches of all threads have done. Times are in nanoseconds, summed over the threads.
+    // `searchTime` is the whole time in searches, which includes the time of the other phases.
+    // The other times stay 0 unless built with FINDER_PHASE_TIMES=1.
+    struct SearchStats {
+        static constexpr int kMaxDepth = Solution::kCapacity;
+
+        uint64_t enabled;
+        uint64_t nodes;
+        uint64_t nodesPerDepth[kMaxDepth];
+        uint64_t moves;
+        uint64_t validateRejections;
+        uint64_t prunes;
+        uint64_t sharedPrunes;
+        uint64_t spinChecks;
+        uint64_t recorderUpdates;
+        uint64_t moveGenerationTime;
+        uint64_t orderingTime;
+        uint64_t spinCheckTime;
+        uint64_t searchTime;
+    };
+
+    // Counters of the search, per thread.
+    // Only the owner thread writes its counters, so counting needs no atomic read-modify-write and no lock.
+    // `stats()` sums the counters of all threads, including the finished ones.
+    class SearchCounters {
+    public:
+        static constexpr bool kEnabled = FINDER_SEARCH_STATS != 0;
+        static constexpr bool kPhaseTimesEnabled = kEnabled && FINDER_PHASE_TIMES != 0;
+
+        static SearchCounters &local() {
+            thread_local SearchCounters counters{};
+            return counters;
+        }
+
+        static SearchStats stats() {
+            auto stats = Registry::visit([](const std::vector<SearchCounters *> &counters, const SearchStats &retired) {
+                auto stats = retired;
+                for (auto threadCounters : counters) {
+                    threadCounters->addTo(stats);
+                }
+                return stats;
+            });
+            stats.enabled = kEnabled ? 1 : 0;
+            return stats;
+        }
+
+        SearchCounters() {
+            Registry::add(this);
+        }
+
+        SearchCounters(const SearchCounters &) = delete;
+
+        SearchCounters &operator=(const SearchCounters &) = delete;
+
+        ~SearchCounters() {
+            Registry::remove(this, [this](SearchStats &retired) {
+                addTo(retired);
+            });
+        }
+
+        void node(int depth) {
+            if constexpr (kEnabled) {
+                count(nodesPerDepth_[std::min(depth, SearchStats::kMaxDepth - 1)], 1);
+            }
+        }
+
+        void moves(size_t numOfMoves) {
+            if constexpr (kEnabled) {
+                count(moves_, numOfMoves);
+            }
+        }
+
+        void rejected() {
+            if constexpr (kEnabled) {
+                count(validateRejections_, 1);
+            }
+        }
+
+        void pruned(bool shared) {
+            if constexpr (kEnabled) {
+                count(shared ? sharedPrunes_ : prunes_, 1);
+            }
+        }
+
+        void spinChecked() {
+            if constexpr (kEnabled) {
+                count(spinChecks_, 1);
+            }
+        }
+
+        void updated() {
+            if constexpr (kEnabled) {
+                count(recorderUpdates_, 1);
+            }
+        }
+
+        void elapsed(SearchPhase phase, int64_t nanos) {
+            if constexpr (kEnabled) {
+                count(times_[static_cast<int>(phase)], static_cast<uint64_t>(nanos));
+            }
+        }
+
+    private:
+        static constexpr int kNumOfPhases = 4;
+
+        using Registry = ThreadRegistry<SearchCounters, SearchStats>;
+
+        static void count(std::atomic<uint64_t> &counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        static uint64_t read(const std::atomic<uint64_t> &counter) {
+            return counter.load(std::memory_order_relaxed);
+        }
+
+        void addTo(SearchStats &stats) const {
+            for (int depth = 0; depth < SearchStats::kMaxDepth; ++depth) {
+                auto nodes = read(nodesPerDepth_[depth]);
+                stats.nodesPerDepth[depth] += nodes;
+                stats.nodes += nodes;
+            }
+            stats.moves += read(moves_);
+            stats.validateRejections += read(validateRejections_);
+            stats.prunes += read(prunes_);
+            stats.sharedPrunes += read(sharedPrunes_);
+            stats.spinChecks += read(spinChecks_);
+            stats.recorderUpdates += read(recorderUpdates_);
+            stats.moveGenerationTime += read(times_[static_cast<int>(SearchPhase::MoveGeneration)]);
+            stats.orderingTime += read(times_[static_cast<int>(SearchPhase::Ordering)]);
+            stats.spinCheckTime += read(times_[static_cast<int>(SearchPhase::SpinCheck)]);
+            stats.searchTime += read(times_[static_cast<int>(SearchPhase::Search)]);
+        }
+
+        std::atomic<uint64_t> nodesPerDepth_[SearchStats::kMaxDepth]{};
+        std::atomic<uint64_t> moves_{0};
+        std::atomic<uint64_t> validateRejections_{0};
+        std::atomic<uint64_t> prunes_{0};
+        std::atomic<uint64_t> sharedPrunes_{0};
+        std::atomic<uint64_t> spinChecks_{0};
+        std::atomic<uint64_t> recorderUpdates_{0};
+        std::atomic<uint64_t> times_[kNumOfPhases]{};
+    };
+
+    // Adds the time until the end of the scope to a phase.
+    // The phases inside a node are only timed with FINDER_PHASE_TIMES, the phase is a constant where it is used so the check folds away
+    class PhaseTimer {
+    public:
+        explicit PhaseTimer(SearchPhase phase) : phase_(phase) {
+            if (timed(phase_)) {
+                start_ = now();
+            }
+        }
+
+        PhaseTimer(const PhaseTimer &) = delete;
+
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+        ~PhaseTimer() {
+            if (timed(phase_)) {
+                SearchCounters::local().elapsed(phase_, now() - start_);
+            }
+        }
+
+    private:
+        static constexpr bool timed(SearchPhase phase) {
+            return phase == SearchPhase::Search ? SearchCounters::kEnabled : SearchCounters::kPhaseTimesEnabled;
+        }
+
+        static int64_t now() {
+            auto time = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+        }
+
+        SearchPhase phase_;
+        int64_t start_ = 0;
+    };
+}
+
+#endif //FINDER_SEARCH_STATS_HPP
@@ -0,0 +1,46 @@
+#ifndef FINDER_SHARED_BOUND_HPP
+#define FINDER_SHARED_BOUND_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "cancellation.hpp"
+
+namespace finder {
+    // The strongest pruning bound among the records found by all search tasks.
+    // A bound is the packed value of `Recorder::bound()`. A larger value prunes more, and 0 prunes nothing.
+    // Any record is a valid bound for the whole search, so the tasks only have to agree on the maximum.
+    class SharedBound {
+    public:
+        void clear() {
+            value_.store(0, std::memory_order_relaxed);
+            firstTime_.store(0, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] uint64_t load() const {
+            return value_.load(std::memory_order_relaxed);
+        }
+
+        // When the first record was published, as `CancellationToken::now()`. 0 if none has been
+        [[nodiscard]] int64_t firstTime() const {
+            return firstTime_.load(std::memory_order_relaxed);
+        }
+
+        void publish(uint64_t bound) {
+            if (firstTime_.load(std::memory_order_relaxed) == 0) {
+                int64_t none = 0;
+                firstTime_.compare_exchange_strong(none, CancellationToken::now(), std::memory_order_relaxed);
+            }
+
+            uint64_t current = value_.load(std::memory_order_relaxed);
+            while (current < bound && !value_.compare_exchange_weak(current, bound, std::memory_order_relaxed)) {
+            }
+        }
+
+    private:
+        std::atomic<uint64_t> value_{0};
+        std::atomic<int64_t> firstTime_{0};
+    };
+}
+
+#endif //FINDER_SHARED_BOUND_HPP
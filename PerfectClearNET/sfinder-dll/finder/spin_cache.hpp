@@ -0,0 +1,86 @@
+#ifndef FINDER_SPIN_CACHE_HPP
+#define FINDER_SPIN_CACHE_HPP
+
+#include <array>
+#include <cstdint>
+
+#include "transposition_table.hpp"
+
+#include "../core/field.hpp"
+#include "../core/moves.hpp"
+#include "../core/piece.hpp"
+
+namespace finder {
+    // Remembers how placements were classified by `getAttackIfTSpin` and `getAttackIfAllSpins`.
+    // The same placements come up again in sibling branches, hold branches and other tasks,
+    // and each classification runs a reachability search.
+    //
+    // A classification depends only on the field, the placement and the rotation system, so entries never go stale.
+    // The cache is per thread and is cleared when the factory changes.
+    // A slot holds the key with the kind in its lowest 2 bits, and is simply overwritten on collision.
+    class SpinCache {
+    public:
+        enum Kind : uint8_t {
+            Unknown = 0,
+            NoSpin = 1,
+            Mini = 2,
+            Regular = 3,
+        };
+
+        // Distinguishes the classifications of a placement
+        enum Rule : uint8_t {
+            TSpin = 0,
+            AllSpins = 1,
+            AllSpinsAlwaysRegular = 2,
+        };
+
+        static constexpr int kSizeBits = 13;
+
+        template<bool Allow180, bool AllowSoftdropTap>
+        static SpinCache &local(const core::Factory &factory) {
+            thread_local SpinCache cache{};
+
+            if (cache.factory_ != &factory) {
+                cache.entries_.fill(0);
+                cache.factory_ = &factory;
+            }
+
+            return cache;
+        }
+
+        [[nodiscard]] static uint64_t key(
+                const core::Field &field, Rule rule, core::PieceType pieceType, const core::Move &move
+        ) {
+            uint64_t meta = static_cast<uint64_t>(rule) << 14U
+                            | static_cast<uint64_t>(pieceType) << 11U
+                            | static_cast<uint64_t>(move.rotateType) << 9U
+                            | static_cast<uint64_t>(move.x) << 5U
+                            | static_cast<uint64_t>(move.y);
+
+            uint64_t hash = mixHash(meta);
+            hash = mixHash(hash ^ field.xBoardLow);
+            hash = mixHash(hash ^ field.xBoardMidLow);
+            hash = mixHash(hash ^ field.xBoardMidHigh);
+            hash = mixHash(hash ^ field.xBoardHigh);
+            return hash & ~kKindMask;
+        }
+
+        [[nodiscard]] Kind find(uint64_t key) const {
+            auto entry = entries_[(key >> 2U) & kMask];
+            return (entry & ~kKindMask) == key ? static_cast<Kind>(entry & kKindMask) : Kind::Unknown;
+        }
+
+        void store(uint64_t key, Kind kind) {
+            entries_[(key >> 2U) & kMask] = key | kind;
+        }
+
+    private:
+        static constexpr uint64_t kKindMask = 3U;
+        static constexpr uint64_t kMask = (1U << kSizeBits) - 1U;
+
+        std::array<uint64_t, 1U << kSizeBits> entries_{};
+        const core::Factory *factory_ = nullptr;
+    };
+}
+
+#endif //FINDER_SPIN_CACHE_HPP
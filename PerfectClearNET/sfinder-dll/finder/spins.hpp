@@ -1,6 +1,9 @@
 #ifndef FINDER_SPINS_HPP
 #define FINDER_SPINS_HPP
 
+#include "spin_cache.hpp"
+#include "search_stats.hpp"
+
 #include "../core/piece.hpp"
 #include "../core/moves.hpp"
 #include "../core/types.hpp"
@@ -22,6 +25,31 @@ namespace finder {
             }
             return !field.isEmpty(x, y);
         }
+
+        // Same as `reachable.checks` for the move, unless the move generator already knows it
+        template<bool Allow180, bool AllowSoftdropTap>
+        bool canReachByRotation(
+                core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable,
+                const core::Field &field, core::PieceType pieceType, const core::Move &move
+        ) {
+            if (move.rotation != core::Rotation::Unknown) {
+                return move.rotation == core::Rotation::Yes;
+            }
+            return reachable.checks(field, pieceType, move.rotateType, move.x, move.y, kFieldHeight);
+        }
+
+        inline int getSpinAttack(SpinCache::Kind kind, int numCleared, bool b2b) {
+            switch (kind) {
+                case SpinCache::Kind::Regular: {
+                    int baseAttack = numCleared * 2;
+                    return b2b ? baseAttack + 1 : baseAttack;
+                }
+                case SpinCache::Kind::Mini:
+                    return b2b ? 1 : 0;
+                default:
+                    return 0;
+            }
+        }
     }
 
     inline TSpinShapes getTSpinShape(const core::Field &field, int x, int y, core::RotateType rotateType) {
@@ -53,35 +81,20 @@ namespace finder {
         return TSpinShapes::NoShape;
     }
 
-    //  Caution: mini attack is 0
-    template<bool Allow180, bool AllowSoftdropTap>
-    constexpr int getAttackIfTSpin(
-            core::srs::MoveGenerator<Allow180, AllowSoftdropTap> &moveGenerator,
+    template<bool Allow180, bool AllowSoftdropTap, class M>
+    SpinCache::Kind classifyTSpin(
+            M &moveGenerator,
             core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable,
             const core::Factory &factory, const core::Field &field,
-            core::PieceType pieceType, const core::Move &move, int numCleared, bool b2b
+            core::PieceType pieceType, const core::Move &move, TSpinShapes shapes
     ) {
-        if (pieceType != core::PieceType::T) {
-            return 0;
-        }
-
-        if (numCleared == 0) {
-            return 0;
-        }
-
         auto rotateType = move.rotateType;
-        auto shapes = getTSpinShape(field, move.x, move.y, rotateType);
-        if (shapes == TSpinShapes::NoShape) {
-            return 0;
-        }
-
-        if (!reachable.checks(field, pieceType, rotateType, move.x, move.y, kFieldHeight)) {
-            return 0;
+        if (!canReachByRotation(reachable, field, pieceType, move)) {
+            return SpinCache::Kind::NoSpin;
         }
 
         if (shapes == TSpinShapes::RegularShape) {
-            int baseAttack = numCleared * 2;
-            return b2b ? baseAttack + 1 : baseAttack;
+            return SpinCache::Kind::Regular;
         }
 
         // Checks mini or regular (Last SRS test pattern)
@@ -119,8 +132,7 @@ namespace finder {
                 if (srsResult == lastOffsetIndex) {
                     // T-Spin Regular if come back to the place
                     if (moveGenerator.canReach(field, pieceType, fromRotate, fromX, fromY, kFieldHeight)) {
-                        int baseAttack = numCleared * 2;
-                        return b2b ? baseAttack + 1 : baseAttack;
+                        return SpinCache::Kind::Regular;
                     }
                 }
 
@@ -155,8 +167,7 @@ namespace finder {
                 if (srsResult == lastOffsetIndex) {
                     // T-Spin Regular if come back to the place
                     if (moveGenerator.canReach(field, pieceType, fromRotate, fromX, fromY, kFieldHeight)) {
-                        int baseAttack = numCleared * 2;
-                        return b2b ? baseAttack + 1 : baseAttack;
+                        return SpinCache::Kind::Regular;
                     }
                 }
 
@@ -164,17 +175,19 @@ namespace finder {
             }
         }
 
-        return b2b ? 1 : 0;
+        return SpinCache::Kind::Mini;
     }
 
-    template<bool AlwaysRegularAttack, bool Allow180, bool AllowSoftdropTap>
-    constexpr int getAttackIfAllSpins(
-            core::srs::MoveGenerator<Allow180, AllowSoftdropTap> &moveGenerator,
+    //  Caution: mini attack is 0
+    //  `M` is a move generator that has `canReach`, such as `core::srs::MoveGenerator`
+    template<bool Allow180, bool AllowSoftdropTap, class M = core::srs::MoveGenerator<Allow180, AllowSoftdropTap>>
+    int getAttackIfTSpin(
+            M &moveGenerator,
             core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable,
             const core::Factory &factory, const core::Field &field,
             core::PieceType pieceType, const core::Move &move, int numCleared, bool b2b
     ) {
-        if (pieceType == core::PieceType::O) {
+        if (pieceType != core::PieceType::T) {
             return 0;
         }
 
@@ -182,11 +195,39 @@ namespace finder {
             return 0;
         }
 
-        auto rotateType = move.rotateType;
-        if (!reachable.checks(field, pieceType, rotateType, move.x, move.y, kFieldHeight)) {
+        auto shapes = getTSpinShape(field, move.x, move.y, move.rotateType);
+        if (shapes == TSpinShapes::NoShape) {
             return 0;
         }
 
+        PhaseTimer timer(SearchPhase::SpinCheck);
+        SearchCounters::local().spinChecked();
+
+        auto &cache = SpinCache::local<Allow180, AllowSoftdropTap>(factory);
+        auto key = SpinCache::key(field, SpinCache::Rule::TSpin, pieceType, move);
+
+        auto kind = cache.find(key);
+        if (kind == SpinCache::Kind::Unknown) {
+            kind = classifyTSpin(moveGenerator, reachable, factory, field, pieceType, move, shapes);
+            cache.store(key, kind);
+        }
+
+        return getSpinAttack(kind, numCleared, b2b);
+    }
+
+    // `numCleared` is decided by the field and the placement, so it does not have to be a part of the key
+    template<bool AlwaysRegularAttack, bool Allow180, bool AllowSoftdropTap, class M>
+    SpinCache::Kind classifyAllSpins(
+            M &moveGenerator,
+            core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable,
+            const core::Factory &factory, const core::Field &field,
+            core::PieceType pieceType, const core::Move &move, int numCleared
+    ) {
+        auto rotateType = move.rotateType;
+        if (!canReachByRotation(reachable, field, pieceType, move)) {
+            return SpinCache::Kind::NoSpin;
+        }
+
         auto &blocks = factory.get(pieceType, move.rotateType);
 
         auto x = move.x;
@@ -197,12 +238,10 @@ namespace finder {
                 && !field.canPut(blocks, x, y + 1)
         )) {
             // It's not immobile
-            return 0;
+            return SpinCache::Kind::NoSpin;
         }
 
         // It's spin
-        int baseAttack = numCleared * 2;
-
         if constexpr (!AlwaysRegularAttack) {
             auto &piece = factory.get(pieceType);
 
@@ -224,7 +263,7 @@ namespace finder {
                         moveGenerator.canReach(field, pieceType, fromRotate, x, y, kFieldHeight)) {
                         // NOT kicked
                         // Regular is enable or regular spin
-                        return b2b ? baseAttack + 1 : baseAttack;
+                        return SpinCache::Kind::Regular;
                     }
                 }
             }
@@ -247,7 +286,7 @@ namespace finder {
                         moveGenerator.canReach(field, pieceType, fromRotate, x, y, kFieldHeight)) {
                         // NOT kicked
                         // Regular is enable or regular spin
-                        return b2b ? baseAttack + 1 : baseAttack;
+                        return SpinCache::Kind::Regular;
                     }
                 }
             }
@@ -258,7 +297,7 @@ namespace finder {
             // Judged as mini if doesn't clear every line it occupies.
             if (numCleared != blocks.height) {
                 // mini
-                return b2b ? 1 : 0;
+                return SpinCache::Kind::Mini;
             }
 
             // NOT mini
@@ -266,7 +305,38 @@ namespace finder {
 
         // If `AlwaysRegularAttack` is true, all spins attack is judged as regular
         // Regular is enable or regular spin
-        return b2b ? baseAttack + 1 : baseAttack;
+        return SpinCache::Kind::Regular;
+    }
+
+    template<bool AlwaysRegularAttack, bool Allow180, bool AllowSoftdropTap, class M = core::srs::MoveGenerator<Allow180, AllowSoftdropTap>>
+    int getAttackIfAllSpins(
+            M &moveGenerator,
+            core::srs_rotate_end::Reachable<Allow180, AllowSoftdropTap> &reachable,
+            const core::Factory &factory, const core::Field &field,
+            core::PieceType pieceType, const core::Move &move, int numCleared, bool b2b
+    ) {
+        if (pieceType == core::PieceType::O) {
+            return 0;
+        }
+
+        if (numCleared == 0) {
+            return 0;
+        }
+
+        PhaseTimer timer(SearchPhase::SpinCheck);
+        SearchCounters::local().spinChecked();
+
+        auto rule = AlwaysRegularAttack ? SpinCache::Rule::AllSpinsAlwaysRegular : SpinCache::Rule::AllSpins;
+        auto &cache = SpinCache::local<Allow180, AllowSoftdropTap>(factory);
+        auto key = SpinCache::key(field, rule, pieceType, move);
+
+        auto kind = cache.find(key);
+        if (kind == SpinCache::Kind::Unknown) {
+            kind = classifyAllSpins<AlwaysRegularAttack>(moveGenerator, reachable, factory, field, pieceType, move, numCleared);
+            cache.store(key, kind);
+        }
+
+        return getSpinAttack(kind, numCleared, b2b);
     }
 }
 
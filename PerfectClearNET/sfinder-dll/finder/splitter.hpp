@@ -0,0 +1,94 @@
+#ifndef FINDER_SPLITTER_HPP
+#define FINDER_SPLITTER_HPP
+
+#include <atomic>
+#include <functional>
+
+#include "types.hpp"
+#include "thread_pool.hpp"
+
+#include "../core/field.hpp"
+
+namespace finder {
+    // Counts the tasks queued and running on the workers, to know whether some of them are idle.
+    // Searches running side by side share one, so that none of them splits while another has tasks waiting.
+    // The workers are counted on each call, so a search keeps feeding a pool resized while it runs.
+    class WorkerLoad {
+    public:
+        explicit WorkerLoad(const ThreadPool &pool) : pool_(pool) {
+        }
+
+        [[nodiscard]] bool hungry() const {
+            return waiting_.load(std::memory_order_relaxed) == 0 && running_.load(std::memory_order_relaxed) < pool_.size();
+        }
+
+        void queued() {
+            waiting_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void dropped() {
+            waiting_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void started() {
+            running_.fetch_add(1, std::memory_order_relaxed);
+            waiting_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void finished() {
+            running_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+    private:
+        const ThreadPool &pool_;
+
+        std::atomic<int> waiting_{0};
+        std::atomic<int> running_{0};
+    };
+
+    // Hands subtrees over to idle workers.
+    // While some workers have nothing to do, a busy search passes its next child to `donate` instead of searching it.
+    // `donate` queues the subtree as a new task and returns false if it cannot.
+    template<class C>
+    class Splitter {
+    public:
+        using Donate = std::function<bool(const core::Field &, const C &, const Solution &)>;
+
+        // Subtrees with fewer pieces left than this are cheaper to search than to hand over
+        static constexpr int kMinSplitDepth = 3;
+
+        Splitter(WorkerLoad &load, Donate donate) : load_(load), donate_(std::move(donate)) {
+        }
+
+        [[nodiscard]] bool hungry() const {
+            return load_.hungry();
+        }
+
+        bool split(const core::Field &field, const C &candidate, const Solution &solution) {
+            return donate_(field, candidate, solution);
+        }
+
+        // Task lifecycle, to know whether workers are idle
+        void queued() {
+            load_.queued();
+        }
+
+        void dropped() {
+            load_.dropped();
+        }
+
+        void started() {
+            load_.started();
+        }
+
+        void finished() {
+            load_.finished();
+        }
+
+    private:
+        WorkerLoad &load_;
+        Donate donate_;
+    };
+}
+
+#endif //FINDER_SPLITTER_HPP
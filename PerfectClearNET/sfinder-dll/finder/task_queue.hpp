@@ -0,0 +1,126 @@
+#ifndef FINDER_TASK_QUEUE_HPP
+#define FINDER_TASK_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace finder {
+    // A multi-producer multi-consumer queue that takes no lock while it has room, first in first out until then.
+    // The ring is Dmitry Vyukov's bounded queue: each slot has a sequence number which tells
+    // whether it is ready to be written or read, so producers and consumers only race on their own position.
+    // When the ring is full, values spill into a list under a mutex. Searches rarely queue that many tasks.
+    template<class T>
+    class TaskQueue {
+    public:
+        static constexpr uint64_t kCapacity = 1U << 12U;
+
+        TaskQueue() : slots_(std::make_unique<Slot[]>(kCapacity)) {
+            for (uint64_t index = 0; index < kCapacity; ++index) {
+                slots_[index].sequence.store(index, std::memory_order_relaxed);
+            }
+        }
+
+        TaskQueue(const TaskQueue &) = delete;
+
+        TaskQueue &operator=(const TaskQueue &) = delete;
+
+        void push(T &&value) {
+            if (tryPush(value)) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mutexForOverflow_);
+            overflow_.push_back(std::move(value));
+            overflowSize_.store(overflow_.size(), std::memory_order_release);
+        }
+
+        bool pop(T &value) {
+            if (tryPop(value)) {
+                return true;
+            }
+
+            if (overflowSize_.load(std::memory_order_acquire) == 0) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(mutexForOverflow_);
+            if (overflow_.empty()) {
+                return false;
+            }
+
+            value = std::move(overflow_.front());
+            overflow_.pop_front();
+            overflowSize_.store(overflow_.size(), std::memory_order_release);
+            return true;
+        }
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence;
+            T value;
+        };
+
+        // The slot at `position` can be written when its sequence is `position`,
+        // and read when it is `position + 1`. Reading sets it to `position + kCapacity` for the next lap.
+        bool tryPush(T &value) {
+            auto position = enqueuePosition_.load(std::memory_order_relaxed);
+            while (true) {
+                auto &slot = slots_[position % kCapacity];
+                auto sequence = slot.sequence.load(std::memory_order_acquire);
+                auto difference = static_cast<int64_t>(sequence - position);
+
+                if (difference == 0) {
+                    if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.value = std::move(value);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    // Full
+                    return false;
+                } else {
+                    position = enqueuePosition_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool tryPop(T &value) {
+            auto position = dequeuePosition_.load(std::memory_order_relaxed);
+            while (true) {
+                auto &slot = slots_[position % kCapacity];
+                auto sequence = slot.sequence.load(std::memory_order_acquire);
+                auto difference = static_cast<int64_t>(sequence - (position + 1));
+
+                if (difference == 0) {
+                    if (dequeuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        value = std::move(slot.value);
+                        slot.value = T{};
+                        slot.sequence.store(position + kCapacity, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    // Empty
+                    return false;
+                } else {
+                    position = dequeuePosition_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::unique_ptr<Slot[]> slots_;
+
+        // On their own cache lines, so that producers and consumers do not invalidate each other
+        alignas(64) std::atomic<uint64_t> enqueuePosition_{0};
+        alignas(64) std::atomic<uint64_t> dequeuePosition_{0};
+
+        alignas(64) std::atomic<size_t> overflowSize_{0};
+        std::mutex mutexForOverflow_;
+        std::deque<T> overflow_{};
+    };
+}
+
+#endif //FINDER_TASK_QUEUE_HPP
@@ -0,0 +1,49 @@
+#include "thread_pool.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace finder {
+    int ThreadPool::hardwareThreads() {
+        auto threads = static_cast<int>(std::thread::hardware_concurrency());
+        return 0 < threads ? threads : 1;
+    }
+
+    bool ThreadPool::setAffinity(std::thread &thread, int core) {
+#ifdef _WIN32
+        // Masks cover the processor group of the process, up to 64 hardware threads
+        DWORD_PTR processMask = 0;
+        DWORD_PTR systemMask = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+            return false;
+        }
+
+        auto mask = processMask;
+        if (0 <= core) {
+            mask = static_cast<DWORD_PTR>(1) << static_cast<unsigned>(core % 64);
+            if ((mask & processMask) == 0) {
+                return false;
+            }
+        }
+
+        return SetThreadAffinityMask(static_cast<HANDLE>(thread.native_handle()), mask) != 0;
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        if (core < 0) {
+            for (int index = 0; index < hardwareThreads() && index < CPU_SETSIZE; ++index) {
+                CPU_SET(index, &set);
+            }
+        } else {
+            CPU_SET(core % CPU_SETSIZE, &set);
+        }
+
+        return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#endif
+    }
+}
@@ -1,11 +1,14 @@
 #ifndef FINDER_THREAD_POOLS_HPP
 #define FINDER_THREAD_POOLS_HPP
 
-#include <vector>
-#include <thread>
-#include <queue>
+#include <algorithm>
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 #define BOOST_THREAD_PROVIDES_FUTURE
 #define BOOST_THREAD_PROVIDES_VARIADIC_THREAD
@@ -13,6 +16,9 @@
 #include <boost/thread/future.hpp>
 #include <boost/thread.hpp>
 
+#include "task_queue.hpp"
+#include "trace.hpp"
+
 namespace finder {
     class TaskStatus {
     public:
@@ -54,195 +60,214 @@ namespace finder {
     template<typename T>
     using Callable = std::function<T(const TaskStatus &)>;
 
+    // Runs the queued tasks on the threads which call `execute`.
+    // Queueing and taking a task takes no lock: the queue is lock-free, the outstanding tasks are an atomic counter,
+    // and idle workers sleep on an atomic (a futex on Linux, WaitOnAddress on Windows) which `push` only wakes if someone sleeps.
     class Tasks {
     public:
         void push(const Runnable &runnable) {
-            {
-                boost::lock(mutexForQueue_, mutexForAbort_);
-				boost::lock_guard<boost::mutex> lk1(mutexForQueue_, boost::adopt_lock);
-				boost::lock_guard<boost::mutex> lk2(mutexForAbort_, boost::adopt_lock);
-
-                if (status_.notWorking()) {
-                    throw std::runtime_error("Not working");
-                }
-
-                queue_.push(runnable);
-                counter += 1;
+            auto id = Trace::enabled() ? Trace::nextId() : 0;
+            Trace::record(Trace::Type::Enqueue, id);
+
+            // Counted before the status is checked, so that `abort` either waits for the task or the task is refused
+            outstanding_.fetch_add(1, std::memory_order_seq_cst);
+            if (status_.notWorking()) {
+                completed();
+                throw std::runtime_error("Not working");
             }
 
-            conditionForQueue_.notify_one();
-            conditionForSleep_.notify_one();
+            queue_.push(Entry{runnable, id});
+            wake(false);
         }
 
-        void execute() {
+        // Runs tasks until the pool terminates, or `retired` is set between two tasks
+        void execute(const std::atomic<bool> &retired) {
+            Entry entry;
+
             while (true) {
-                Runnable runnable;
-
-                {
-					boost::unique_lock<boost::mutex> guard(mutexForQueue_);
-                    conditionForQueue_.wait(guard, [this] { return status_.notWorking() || !queue_.empty(); });
-
-                    if (queue_.empty()) {
-                        if (status_.notWorking()) {
-                            if (status_.terminated()) {
-                                // All tasks completed, so finish pool
-                                return;
-                            }
-
-                            // All tasks completed, so go to sleep
-                            conditionForAbort_.notify_all();
-                            conditionForSleep_.wait(guard, [this] {
-                                return status_.working() || status_.terminated();
-                            });
-                        }
-
-                        // Working but not found task or after sleeping
-                        continue;
-                    }
+                if (retired.load(std::memory_order_acquire)) {
+                    // Pass on a wake-up that may have been meant for a task
+                    wake(false);
+                    return;
+                }
 
-                    // Execute task
+                if (queue_.pop(entry)) {
+                    run(entry);
+                    continue;
+                }
+
+                // Announce the sleep before looking at the queue again, so that `push` either sees the sleeper or the sleeper sees the task
+                sleepers_.fetch_add(1, std::memory_order_seq_cst);
+                auto signal = signal_.load(std::memory_order_seq_cst);
 
-                    runnable = queue_.front();
-                    queue_.pop();
+                if (queue_.pop(entry)) {
+                    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                    run(entry);
+                    continue;
                 }
 
-                runnable(status_);
+                if (status_.terminated()) {
+                    // All tasks completed, so finish pool
+                    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
 
-                {
-                    boost::lock_guard<boost::mutex> guard(mutexForAbort_);
-                    counter -= 1;
+                if (retired.load(std::memory_order_acquire)) {
+                    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                    continue;
                 }
+
+                signal_.wait(signal, std::memory_order_seq_cst);
+                sleepers_.fetch_sub(1, std::memory_order_relaxed);
             }
         }
 
         void abort() {
-            {
-                boost::lock_guard<boost::mutex> guard(mutexForQueue_);
-                status_.abort();
-            }
+            Trace::record(Trace::Type::AbortBegin);
 
-            conditionForQueue_.notify_all();
-            conditionForSleep_.notify_all();
+            status_.abort();
 
             // sleep until completed all tasks
-            {
-                boost::unique_lock<boost::mutex> guard(mutexForAbort_);
-                conditionForAbort_.wait(guard, [this] {
-                    return counter == 0;
-                });
-            }
+            waitForCompletion();
 
-            {
-                boost::lock_guard<boost::mutex> guard(mutexForQueue_);
-                status_.resume();
-            }
+            status_.resume();
 
-            conditionForQueue_.notify_all();
-            conditionForSleep_.notify_all();
+            Trace::record(Trace::Type::AbortEnd);
         }
 
         void shutdown() {
-            {
-                boost::lock_guard<boost::mutex> guard(mutexForQueue_);
-                status_.abort();
-            }
-
-            conditionForQueue_.notify_all();
-            conditionForSleep_.notify_all();
+            status_.abort();
 
             // sleep until completed all tasks
-            {
-                boost::unique_lock<boost::mutex> guard(mutexForAbort_);
-                conditionForAbort_.wait(guard, [this] {
-                    return counter == 0;
-                });
-            }
-
-            {
-                boost::lock_guard<boost::mutex> guard(mutexForQueue_);
-                status_.terminate();
-            }
+            waitForCompletion();
 
-            conditionForQueue_.notify_all();
-            conditionForSleep_.notify_all();
-            conditionForAbort_.notify_all();
+            status_.terminate();
+            wake(true);
         }
 
         void shutdownNow() {
-            {
-                boost::lock_guard<boost::mutex> guard(mutexForQueue_);
-                status_.terminate();
+            status_.terminate();
 
-                counter -= queue_.size();
-
-                std::queue<Runnable> empty{};
-                std::swap(queue_, empty);
+            // Drop the queued tasks
+            Entry entry;
+            while (queue_.pop(entry)) {
+                completed();
             }
 
-            conditionForQueue_.notify_all();
-            conditionForSleep_.notify_all();
-            conditionForAbort_.notify_all();
+            wake(true);
         }
 
         bool terminated() const {
             return status_.terminated();
         }
 
+        // Wakes the sleeping workers, e.g. to let them see they are retired
+        void wakeAll() {
+            wake(true);
+        }
+
     private:
-		boost::mutex mutexForQueue_;
-		boost::mutex mutexForAbort_;
+        // The id ties the task to its events in the trace. 0 if tracing was off when it was queued.
+        struct Entry {
+            Runnable runnable;
+            uint64_t id;
+        };
+
+        void run(Entry &entry) {
+            Trace::record(Trace::Type::Start, entry.id);
+            entry.runnable(status_);
+            Trace::record(Trace::Type::End, entry.id);
+
+            entry.runnable = nullptr;
+            completed();
+        }
+
+        void completed() {
+            if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                outstanding_.notify_all();
+            }
+        }
+
+        void waitForCompletion() {
+            auto outstanding = outstanding_.load(std::memory_order_acquire);
+            while (outstanding != 0) {
+                outstanding_.wait(outstanding, std::memory_order_acquire);
+                outstanding = outstanding_.load(std::memory_order_acquire);
+            }
+        }
+
+        void wake(bool all) {
+            signal_.fetch_add(1, std::memory_order_seq_cst);
+
+            if (all) {
+                signal_.notify_all();
+            } else if (0 < sleepers_.load(std::memory_order_seq_cst)) {
+                signal_.notify_one();
+            }
+        }
 
         TaskStatus status_{};
 
-        int counter = 0;
-        std::queue<Runnable> queue_{};
+        TaskQueue<Entry> queue_{};
+
+        // Tasks queued or running
+        alignas(64) std::atomic<uint32_t> outstanding_{0};
 
-		boost::condition_variable conditionForQueue_{};
-		boost::condition_variable conditionForSleep_{};
-		boost::condition_variable conditionForAbort_{};
+        // Bumped by every push, for the workers to sleep on
+        alignas(64) std::atomic<uint32_t> signal_{0};
+        std::atomic<uint32_t> sleepers_{0};
+    };
+
+    // Where the workers run
+    struct ThreadPlacement {
+        // Pin each worker to its own hardware thread
+        bool pin = false;
+        // Keep the first hardware thread for the caller: the automatic thread count leaves it out,
+        // and pinned workers start after it
+        bool reserveCaller = true;
     };
 
     /**
-     * This class is NOT thread-safe.
+     * The pool can be resized while tasks run: new workers join at once, and retired workers leave after their current task.
+     * Resizing and shutting down are serialized, and may run concurrently with `execute`.
      */
     class ThreadPool {
     public:
-        explicit ThreadPool(int n) : tasks_(std::make_unique<Tasks>()) {
-            start(n);
+        // As a thread count, chooses one worker per hardware thread
+        static constexpr int kAuto = 0;
+
+        explicit ThreadPool(int n, ThreadPlacement placement = ThreadPlacement{}) : placement_(placement) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            resize(n);
         }
 
         ~ThreadPool() {
-            if (tasks_->terminated()) {
+            if (tasks_.terminated()) {
                 return;
             }
 
-            tasks_->shutdownNow();
-            for (auto &thread : threads_) {
-                if (thread.joinable()) {
-                    thread.join();
-                }
-            }
-            threads_.clear();
+            tasks_.shutdownNow();
+            joinAll();
         }
 
         // Execute the task
         void execute(const Runnable &runnable) {
-            if (tasks_->terminated()) {
+            if (tasks_.terminated()) {
                 throw std::runtime_error("Thread pool is terminated");
             }
 
-            tasks_->push(runnable);
+            tasks_.push(runnable);
         }
 
         // Execute the task returning result.
         template<typename R>
         boost::future<R> execute(const Callable<R> &callable) {
-            if (tasks_->terminated()) {
+            if (tasks_.terminated()) {
                 throw std::runtime_error("Thread pool is terminated");
             }
 
             auto task = std::make_shared<boost::packaged_task<R(const TaskStatus &)>>(callable);
-            tasks_->push([task](const TaskStatus& status) {
+            tasks_.push([task](const TaskStatus& status) {
                 (*task)(status);
             });
             return std::move(task->get_future());
@@ -252,50 +277,150 @@ namespace finder {
         // The task is notified of the "aborted" status via TaskStatus, but attempts to complete all processing.
         // How long the task ends depends on the task implementation.
         void abort() {
-            if (tasks_->terminated()) {
+            if (tasks_.terminated()) {
                 return;
             }
 
-            tasks_->abort();
+            tasks_.abort();
         }
 
         // After abort tasks and wait they are completed, change current status to "Terminated".
         // Thread pool cannot be operated after shutdown.
         void shutdown() {
-            if (tasks_->terminated()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (tasks_.terminated()) {
                 return;
             }
 
-            tasks_->shutdown();
-            for (auto &thread : threads_) {
-                if (thread.joinable()) {
-                    thread.join();
-                }
-            }
-            threads_.clear();
+            tasks_.shutdown();
+            joinAll();
+        }
+
+        [[nodiscard]] int size() const {
+            return size_.load(std::memory_order_relaxed);
         }
 
-        // Change the number of threads.
-        // Running tasks are aborted and wait for changes to complete.
+        // Change the number of threads. `kAuto` follows the hardware.
+        // Running tasks go on: added workers start taking tasks at once, and removed ones stop after their current task.
         void changeThreadCount(int n) {
-            shutdown();
-            tasks_ = std::make_unique<Tasks>();
-            start(n);
+            Trace::record(Trace::Type::ChangeThreadCount, 0, static_cast<uint32_t>(n));
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (tasks_.terminated()) {
+                return;
+            }
+
+            resize(n);
+        }
+
+        // Change where the workers run. Running workers are moved, and an automatic thread count is updated.
+        void changePlacement(ThreadPlacement placement) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (tasks_.terminated()) {
+                return;
+            }
+
+            placement_ = placement;
+            for (int index = 0; index < static_cast<int>(workers_.size()); ++index) {
+                place(*workers_[index], index);
+            }
+
+            if (automatic_) {
+                resize(kAuto);
+            }
         }
 
+        // The number of hardware threads, at least 1
+        static int hardwareThreads();
+
     private:
-        void start(int n) {
-            assert(0 < n);
-            threads_.clear();
-            for (int count = 0; count < n; ++count) {
-                threads_.emplace_back(std::thread([this]() {
-                    tasks_->execute();
-                }));
+        struct Worker {
+            std::thread thread;
+            std::atomic<bool> retired{false};
+            std::atomic<bool> exited{false};
+        };
+
+        // Moves the thread to the hardware thread `core`, or lets it run anywhere if `core` is negative
+        static bool setAffinity(std::thread &thread, int core);
+
+        void resize(int n) {
+            automatic_ = n <= kAuto;
+            if (automatic_) {
+                n = std::max(1, hardwareThreads() - (placement_.reserveCaller ? 1 : 0));
             }
+
+            reap();
+
+            while (static_cast<int>(workers_.size()) < n) {
+                auto index = static_cast<int>(workers_.size());
+                auto worker = std::make_unique<Worker>();
+                auto &state = *worker;
+                worker->thread = std::thread([this, index, &state]() {
+                    Trace::name("worker " + std::to_string(index));
+                    tasks_.execute(state.retired);
+                    state.exited.store(true, std::memory_order_release);
+                });
+                place(*worker, index);
+                workers_.push_back(std::move(worker));
+            }
+
+            if (n < static_cast<int>(workers_.size())) {
+                while (n < static_cast<int>(workers_.size())) {
+                    workers_.back()->retired.store(true, std::memory_order_release);
+                    retired_.push_back(std::move(workers_.back()));
+                    workers_.pop_back();
+                }
+                tasks_.wakeAll();
+            }
+
+            size_.store(static_cast<int>(workers_.size()), std::memory_order_relaxed);
         }
 
-        std::vector<std::thread> threads_{};
-        std::unique_ptr<Tasks> tasks_;
+        void place(Worker &worker, int index) {
+            if (!placement_.pin) {
+                setAffinity(worker.thread, -1);
+                return;
+            }
+
+            auto cores = hardwareThreads();
+            auto first = placement_.reserveCaller && 1 < cores ? 1 : 0;
+            setAffinity(worker.thread, first + index % (cores - first));
+        }
+
+        // Joins the retired workers which have left
+        void reap() {
+            auto left = std::remove_if(retired_.begin(), retired_.end(), [](const std::unique_ptr<Worker> &worker) {
+                if (!worker->exited.load(std::memory_order_acquire)) {
+                    return false;
+                }
+
+                worker->thread.join();
+                return true;
+            });
+            retired_.erase(left, retired_.end());
+        }
+
+        void joinAll() {
+            for (auto &workers : {&workers_, &retired_}) {
+                for (auto &worker : *workers) {
+                    if (worker->thread.joinable()) {
+                        worker->thread.join();
+                    }
+                }
+                workers->clear();
+            }
+            size_.store(0, std::memory_order_relaxed);
+        }
+
+        Tasks tasks_{};
+
+        std::mutex mutex_;
+        ThreadPlacement placement_;
+        bool automatic_ = false;
+        std::vector<std::unique_ptr<Worker>> workers_{};
+        // Workers finishing their last task
+        std::vector<std::unique_ptr<Worker>> retired_{};
+        std::atomic<int> size_{0};
     };
 }
 
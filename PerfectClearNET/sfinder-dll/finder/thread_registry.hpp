@@ -0,0 +1,68 @@
+#ifndef FINDER_THREAD_REGISTRY_HPP
+#define FINDER_THREAD_REGISTRY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <variant>
+#include <vector>
+
+namespace finder {
+    // The thread-local objects of type `T` of all threads, so that another thread can read them.
+    // An object adds itself when its thread creates it, and removes itself when the thread exits,
+    // folding what it holds into `Retired` so that the totals still count the finished threads.
+    template<class T, class Retired = std::monostate>
+    class ThreadRegistry {
+    public:
+        // `init(number)` is called under the lock, before the object can be visited.
+        // `number` counts the objects added so far, including this one.
+        template<class F>
+        static void add(T *object, F &&init) {
+            auto &state = getState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            init(++state.numOfAdded);
+            state.objects.push_back(object);
+        }
+
+        static void add(T *object) {
+            add(object, [](uint32_t) {});
+        }
+
+        // `retire(retired)` is called under the lock, before the object is removed
+        template<class F>
+        static void remove(T *object, F &&retire) {
+            auto &state = getState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            retire(state.retired);
+            state.objects.erase(std::find(state.objects.begin(), state.objects.end(), object));
+        }
+
+        static void remove(T *object) {
+            remove(object, [](Retired &) {});
+        }
+
+        // Calls `visit(objects, retired)` under the lock, while no object can be added or removed
+        template<class F>
+        static decltype(auto) visit(F &&visit) {
+            auto &state = getState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            return visit(static_cast<const std::vector<T *> &>(state.objects), static_cast<const Retired &>(state.retired));
+        }
+
+    private:
+        struct State {
+            std::mutex mutex;
+            std::vector<T *> objects;
+            Retired retired{};
+            uint32_t numOfAdded = 0;
+        };
+
+        // Never destroyed, since threads may exit after the static objects are destroyed
+        static State &getState() {
+            static auto state = new State{};
+            return *state;
+        }
+    };
+}
+
+#endif //FINDER_THREAD_REGISTRY_HPP
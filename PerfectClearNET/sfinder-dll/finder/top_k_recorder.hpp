@@ -0,0 +1,118 @@
+#ifndef FINDER_TOP_K_RECORDER_HPP
+#define FINDER_TOP_K_RECORDER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <vector>
+
+#include "types.hpp"
+
+namespace finder {
+    template<class C, class R>
+    class Recorder;
+
+    // Called with each perfect clear a search reaches, from the thread which found it
+    using SolutionListener = std::function<void(const Solution &)>;
+
+    inline bool isSameSolution(const Solution &left, const Solution &right) {
+        return std::equal(left.begin(), left.end(), right.begin(), right.end(), [](const Operation &l, const Operation &r) {
+            return l.pieceType == r.pieceType && l.rotateType == r.rotateType && l.x == r.x && l.y == r.y;
+        });
+    }
+
+    // Keeps the K best distinct solutions, ordered as `Recorder::shouldUpdate` orders them.
+    // The records are a heap with the worst of them on top, so that a search can prune against it once K are kept.
+    template<class C, class R>
+    class TopKRecorder {
+    public:
+        // Each record comes with the candidate rebuilt from it, which is what `shouldUpdate` compares.
+        // Records may drop fields of the candidate, so entries are ranked only by what is recorded
+        struct Entry {
+            C candidate;
+            Recorder<C, R> recorder;
+        };
+
+        explicit TopKRecorder(int capacity = 1) : capacity_(std::max(capacity, 1)) {
+        }
+
+        void clear() {
+            entries_.clear();
+        }
+
+        [[nodiscard]] int capacity() const {
+            return capacity_;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return entries_.empty();
+        }
+
+        [[nodiscard]] bool full() const {
+            return static_cast<int>(entries_.size()) == capacity_;
+        }
+
+        // The K-th best record. Only valid once full
+        [[nodiscard]] const Recorder<C, R> &worst() const {
+            assert(full());
+            return entries_.front().recorder;
+        }
+
+        // Keeps the solution if it is among the K best and not kept yet. Returns whether it is kept.
+        bool add(const Configure &configure, const C &current, const Solution &solution) {
+            Entry entry{current, Recorder<C, R>{}};
+            entry.recorder.update(configure, current, solution);
+            entry.candidate = toCandidate(entry.recorder.best());
+
+            if (full() && !entries_.front().recorder.shouldUpdate(configure, entry.candidate)) {
+                return false;
+            }
+
+            for (const auto &kept : entries_) {
+                if (isSameSolution(kept.recorder.best().solution, solution)) {
+                    return false;
+                }
+            }
+
+            auto isBetter = [&configure](const Entry &left, const Entry &right) {
+                return right.recorder.shouldUpdate(configure, left.candidate);
+            };
+
+            if (full()) {
+                std::pop_heap(entries_.begin(), entries_.end(), isBetter);
+                entries_.pop_back();
+            }
+
+            entries_.push_back(std::move(entry));
+            std::push_heap(entries_.begin(), entries_.end(), isBetter);
+            return true;
+        }
+
+        void add(const Configure &configure, const TopKRecorder &other) {
+            for (const auto &entry : other.entries_) {
+                add(configure, entry.candidate, entry.recorder.best().solution);
+            }
+        }
+
+        // The kept records, from the best
+        [[nodiscard]] std::vector<R> records(const Configure &configure) const {
+            auto entries = entries_;
+            std::sort(entries.begin(), entries.end(), [&configure](const Entry &left, const Entry &right) {
+                return right.recorder.shouldUpdate(configure, left.candidate);
+            });
+
+            std::vector<R> records{};
+            records.reserve(entries.size());
+            for (const auto &entry : entries) {
+                records.push_back(entry.recorder.best());
+            }
+            return records;
+        }
+
+    private:
+        int capacity_;
+        std::vector<Entry> entries_{};
+    };
+}
+
+#endif //FINDER_TOP_K_RECORDER_HPP
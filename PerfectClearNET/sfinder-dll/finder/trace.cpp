@@ -0,0 +1,180 @@
+#include "trace.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <unordered_map>
+
+namespace finder {
+    namespace {
+        // Microseconds from the beginning of the query, as Chrome traces expect
+        double toMicroseconds(int64_t time, int64_t begin) {
+            return static_cast<double>(time - begin) / 1000.0;
+        }
+
+        void writeEscaped(FILE *file, const std::string &text) {
+            for (auto c : text) {
+                if (c == '"' || c == '\\') {
+                    std::fputc('\\', file);
+                }
+                std::fputc(c, file);
+            }
+        }
+    }
+
+    bool Trace::dump(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+
+        auto begin = begin_.load(std::memory_order_relaxed);
+        auto now = CancellationToken::now();
+
+        struct Thread {
+            uint32_t id;
+            std::string name;
+            std::vector<Event> events;
+        };
+
+        // Copy the events of the query out of the buffers first
+        std::vector<Thread> threads{};
+        Registry::visit([&](const std::vector<Trace *> &buffers, const std::monostate &) {
+            for (auto buffer : buffers) {
+                auto events = buffer->events_.load(std::memory_order_acquire);
+                if (events == nullptr) {
+                    continue;
+                }
+
+                auto size = buffer->size_.load(std::memory_order_acquire);
+                auto thread = Thread{buffer->threadId_, buffer->name_, {}};
+
+                for (auto index = size < kCapacity ? 0 : size - kCapacity; index < size; ++index) {
+                    auto &event = events[index % kCapacity];
+                    if (begin <= event.time) {
+                        thread.events.push_back(event);
+                    }
+                }
+
+                if (!thread.events.empty()) {
+                    threads.push_back(std::move(thread));
+                }
+            }
+        });
+
+        std::unordered_map<uint64_t, int64_t> enqueued{};
+        for (const auto &thread : threads) {
+            for (const auto &event : thread.events) {
+                if (event.type == Type::Enqueue) {
+                    enqueued[event.id] = event.time;
+                }
+            }
+        }
+
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        bool first = true;
+        auto separate = [&]() {
+            if (!first) {
+                std::fprintf(file, ",\n");
+            }
+            first = false;
+        };
+
+        for (const auto &thread : threads) {
+            separate();
+            std::fprintf(file, R"({"name":"thread_name","ph":"M","pid":1,"tid":%u,"args":{"name":")", thread.id);
+            writeEscaped(file, thread.name);
+            std::fprintf(file, "\"}}");
+
+            auto writeTask = [&](const Event &start, int64_t end) {
+                auto startTime = toMicroseconds(start.time, begin);
+                auto found = enqueued.find(start.id);
+                double queued = found != enqueued.end() ? static_cast<double>(start.time - found->second) / 1000.0 : 0.0;
+
+                separate();
+                std::fprintf(
+                        file,
+                        R"({"name":"task","cat":"task","ph":"X","ts":%.3f,"dur":%.3f,"pid":1,"tid":%u,"args":{"id":%)" PRIu64 R"(,"queued us":%.3f}})",
+                        startTime, toMicroseconds(end, begin) - startTime, thread.id, start.id, queued
+                );
+
+                if (found != enqueued.end()) {
+                    separate();
+                    std::fprintf(
+                            file,
+                            R"({"name":"queued","cat":"task","ph":"f","bp":"e","id":%)" PRIu64 R"(,"ts":%.3f,"pid":1,"tid":%u})",
+                            start.id, startTime, thread.id
+                    );
+                }
+            };
+
+            // A thread runs one task and one abort at a time, so an end closes the last start
+            const Event *start = nullptr;
+            const Event *abortBegin = nullptr;
+
+            for (const auto &event : thread.events) {
+                auto time = toMicroseconds(event.time, begin);
+
+                switch (event.type) {
+                    case Type::Enqueue: {
+                        separate();
+                        std::fprintf(
+                                file,
+                                R"({"name":"enqueue","cat":"task","ph":"i","s":"t","ts":%.3f,"pid":1,"tid":%u,"args":{"id":%)" PRIu64 "}},\n"
+                                R"({"name":"queued","cat":"task","ph":"s","id":%)" PRIu64 R"(,"ts":%.3f,"pid":1,"tid":%u})",
+                                time, thread.id, event.id, event.id, time, thread.id
+                        );
+                        break;
+                    }
+                    case Type::Start: {
+                        start = &event;
+                        break;
+                    }
+                    case Type::End: {
+                        if (start != nullptr && start->id == event.id) {
+                            writeTask(*start, event.time);
+                            start = nullptr;
+                        }
+                        break;
+                    }
+                    case Type::AbortBegin: {
+                        abortBegin = &event;
+                        break;
+                    }
+                    case Type::AbortEnd: {
+                        if (abortBegin == nullptr) {
+                            break;
+                        }
+
+                        auto beginTime = toMicroseconds(abortBegin->time, begin);
+                        separate();
+                        std::fprintf(
+                                file, R"({"name":"abort","cat":"pool","ph":"X","ts":%.3f,"dur":%.3f,"pid":1,"tid":%u})",
+                                beginTime, time - beginTime, thread.id
+                        );
+
+                        abortBegin = nullptr;
+                        break;
+                    }
+                    case Type::ChangeThreadCount: {
+                        separate();
+                        std::fprintf(
+                                file,
+                                R"({"name":"changeThreadCount","cat":"pool","ph":"i","s":"g","ts":%.3f,"pid":1,"tid":%u,"args":{"threads":%u}})",
+                                time, thread.id, event.value
+                        );
+                        break;
+                    }
+                }
+            }
+
+            // The caller may be woken by the result of the last task before its end is recorded
+            if (start != nullptr) {
+                writeTask(*start, now);
+            }
+        }
+
+        std::fprintf(file, "\n]}\n");
+        return std::fclose(file) == 0;
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef FINDER_TRACE_HPP
+#define FINDER_TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cancellation.hpp"
+#include "thread_registry.hpp"
+
+namespace finder {
+    // Records how the thread pool schedules tasks, to be viewed as a Chrome trace (chrome://tracing or Perfetto).
+    // Each thread writes its events into its own ring buffer, so recording takes no lock.
+    // Tracing is off by default, and then recording costs one relaxed load.
+    class Trace {
+    public:
+        enum class Type : uint32_t {
+            // A task is queued by the current thread
+            Enqueue = 0,
+            // A worker starts and finishes a task
+            Start = 1,
+            End = 2,
+            // The pool aborts its tasks and waits for them
+            AbortBegin = 3,
+            AbortEnd = 4,
+            // The pool is resized to `value` threads, 0 for one per hardware thread
+            ChangeThreadCount = 5,
+        };
+
+        struct Event {
+            int64_t time;
+            uint64_t id;
+            Type type;
+            uint32_t value;
+        };
+
+        // Events kept per thread. Older ones are overwritten.
+        static constexpr uint64_t kCapacity = 1U << 14U;
+
+        static void enable(bool enabled) {
+            enabled_.store(enabled, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] static bool enabled() {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        // Starts a new query. A dump has the events from here.
+        static void begin() {
+            begin_.store(CancellationToken::now(), std::memory_order_relaxed);
+        }
+
+        // Ids tie the enqueue of a task to its start and end
+        static uint64_t nextId() {
+            return nextId_.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        static void record(Type type, uint64_t id = 0, uint32_t value = 0) {
+            if (!enabled()) {
+                return;
+            }
+
+            local().push(Event{CancellationToken::now(), id, type, value});
+        }
+
+        // Names the current thread in the trace
+        static void name(const std::string &name) {
+            auto &buffer = local();
+            Registry::visit([&](const std::vector<Trace *> &, const std::monostate &) {
+                buffer.name_ = name;
+            });
+        }
+
+        // Writes the events since the last `begin` as a Chrome trace JSON file.
+        // Call it between queries: events written meanwhile may be torn.
+        static bool dump(const std::string &path);
+
+        Trace(const Trace &) = delete;
+
+        Trace &operator=(const Trace &) = delete;
+
+        ~Trace() {
+            Registry::remove(this);
+            delete[] events_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        using Registry = ThreadRegistry<Trace>;
+
+        static Trace &local() {
+            thread_local Trace buffer{};
+            return buffer;
+        }
+
+        Trace() {
+            Registry::add(this, [this](uint32_t number) {
+                threadId_ = number;
+                name_ = "thread " + std::to_string(number);
+            });
+        }
+
+        // Only the owner thread writes.
+        // The buffer is allocated on the first event and published with a release store, since `dump` may read it meanwhile
+        void push(const Event &event) {
+            auto events = events_.load(std::memory_order_relaxed);
+            if (events == nullptr) {
+                events = new Event[kCapacity];
+                events_.store(events, std::memory_order_release);
+            }
+
+            auto size = size_.load(std::memory_order_relaxed);
+            events[size % kCapacity] = event;
+            size_.store(size + 1, std::memory_order_release);
+        }
+
+        inline static std::atomic<bool> enabled_{false};
+        inline static std::atomic<int64_t> begin_{0};
+        inline static std::atomic<uint64_t> nextId_{0};
+
+        std::atomic<Event *> events_{nullptr};
+        std::atomic<uint64_t> size_{0};
+        uint32_t threadId_ = 0;
+        std::string name_{};
+    };
+}
+
+#endif //FINDER_TRACE_HPP
@@ -0,0 +1,101 @@
+#ifndef FINDER_TRANSPOSITION_TABLE_HPP
+#define FINDER_TRANSPOSITION_TABLE_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "../core/field.hpp"
+
+namespace finder {
+    namespace {
+        inline uint64_t mixHash(uint64_t x) {
+            x ^= x >> 33U;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33U;
+            x *= 0xc4ceb9fe1a85ec53ULL;
+            x ^= x >> 33U;
+            return x;
+        }
+    }
+
+    // Remembers search states whose subtree cannot yield any perfect clear.
+    // The table is shared by all search tasks, so every slot is a single atomic word holding the full 64-bit key.
+    // A slot is simply overwritten on collision. Stale entries of previous searches are never matched,
+    // because the generation is mixed into the key.
+    class TranspositionTable {
+    public:
+        static constexpr unsigned int kDefaultMegabytes = 32;
+
+        explicit TranspositionTable(unsigned int megabytes) {
+            resize(megabytes);
+        }
+
+        // Reallocate the table to fit into `megabytes`. 0 disables the table.
+        // Must not be called while searching.
+        void resize(unsigned int megabytes) {
+            entries_.reset();
+            mask_ = 0;
+
+            if (megabytes == 0) {
+                return;
+            }
+
+            uint64_t bytes = static_cast<uint64_t>(megabytes) << 20U;
+            uint64_t size = 1;
+            while (size * 2 * sizeof(std::atomic<uint64_t>) <= bytes) {
+                size *= 2;
+            }
+
+            entries_ = std::make_unique<std::atomic<uint64_t>[]>(size);
+            for (uint64_t index = 0; index < size; ++index) {
+                entries_[index].store(0, std::memory_order_relaxed);
+            }
+            mask_ = size - 1;
+        }
+
+        // Invalidate all entries of previous searches. Call it once before starting a new search.
+        void nextGeneration() {
+            generation_ += 1;
+        }
+
+        [[nodiscard]] bool enabled() const {
+            return entries_ != nullptr;
+        }
+
+        // `extra` distinguishes states whose legal moves also depend on the candidate (e.g. B2B in TETR.IO S2)
+        [[nodiscard]] uint64_t key(
+                const core::Field &field, int currentIndex, int holdIndex, int leftLine, uint64_t extra
+        ) const {
+            uint64_t meta = generation_ << 24U
+                            | extra << 18U
+                            | static_cast<uint64_t>(leftLine) << 12U
+                            | static_cast<uint64_t>(currentIndex) << 6U
+                            | static_cast<uint64_t>(holdIndex + 1);
+
+            uint64_t hash = mixHash(meta);
+            hash = mixHash(hash ^ field.xBoardLow);
+            hash = mixHash(hash ^ field.xBoardMidLow);
+            hash = mixHash(hash ^ field.xBoardMidHigh);
+            hash = mixHash(hash ^ field.xBoardHigh);
+
+            // 0 is reserved for empty slots
+            return hash != 0 ? hash : 1;
+        }
+
+        [[nodiscard]] bool isDead(uint64_t key) const {
+            return entries_[key & mask_].load(std::memory_order_relaxed) == key;
+        }
+
+        void markDead(uint64_t key) {
+            entries_[key & mask_].store(key, std::memory_order_relaxed);
+        }
+
+    private:
+        std::unique_ptr<std::atomic<uint64_t>[]> entries_{};
+        uint64_t mask_ = 0;
+        uint64_t generation_ = 0;
+    };
+}
+
+#endif //FINDER_TRANSPOSITION_TABLE_HPP
@@ -1,6 +1,10 @@
 #ifndef FINDER_TYPES_HPP
 #define FINDER_TYPES_HPP
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
 #include "../core/moves.hpp"
 #include "../core/types.hpp"
 
@@ -16,6 +20,7 @@ namespace finder {
         const bool leastLineClears;
         bool alwaysRegularAttack;
         uint8_t lastHoldPriority;  // 0bEOZSJLIT // 0b11000000 -> Give high priority to solutions that last hold is Empty,O
+        int topK = 1;  // Number of best distinct solutions to keep. Above 1, searches prune against the K-th instead of the best
     };
 
     struct Operation {
@@ -38,8 +43,82 @@ namespace finder {
         int score;
     };
 
-    using Solution = std::vector<Operation>;
-    inline const Solution kNoSolution = std::vector<Operation>();
+    // Operations of the pieces in order. They are stored inline, so creating and copying a solution never allocates.
+    // Copies move only the operations in use.
+    class Solution {
+    public:
+        // Enough to clear 20 lines from an empty field
+        static constexpr int kCapacity = core::FIELD_WIDTH * 20 / 4;
+
+        Solution() = default;
+
+        explicit Solution(size_t size) {
+            resize(size);
+        }
+
+        Solution(const Solution &rhs) : size_(rhs.size_) {
+            std::copy(rhs.begin(), rhs.end(), operations_);
+        }
+
+        Solution &operator=(const Solution &rhs) {
+            if (this != &rhs) {
+                size_ = rhs.size_;
+                std::copy(rhs.begin(), rhs.end(), operations_);
+            }
+            return *this;
+        }
+
+        [[nodiscard]] size_t size() const {
+            return size_;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return size_ == 0;
+        }
+
+        void clear() {
+            size_ = 0;
+        }
+
+        // New operations are value-initialized, as in `std::vector`
+        void resize(size_t size) {
+            assert(size <= static_cast<size_t>(kCapacity));
+            std::fill(operations_ + size_, operations_ + (size_ < size ? size : size_), Operation{});
+            size_ = size;
+        }
+
+        Operation &operator[](size_t index) {
+            assert(index < size_);
+            return operations_[index];
+        }
+
+        const Operation &operator[](size_t index) const {
+            assert(index < size_);
+            return operations_[index];
+        }
+
+        Operation *begin() {
+            return operations_;
+        }
+
+        Operation *end() {
+            return operations_ + size_;
+        }
+
+        [[nodiscard]] const Operation *begin() const {
+            return operations_;
+        }
+
+        [[nodiscard]] const Operation *end() const {
+            return operations_ + size_;
+        }
+
+    private:
+        size_t size_ = 0;
+        Operation operations_[kCapacity];
+    };
+
+    inline const Solution kNoSolution = Solution();
 
     // For fast search
     struct FastCandidate {
@@ -190,6 +269,54 @@ namespace finder {
         bool isClean;
         bool isFlatI;
     };
+
+    // The candidate that reaches the record, to compare records with each other
+    inline FastCandidate toCandidate(const FastRecord &record) {
+        return FastCandidate{
+                record.currentIndex,
+                record.holdIndex, record.leftLine,
+                record.depth, record.softdropCount,
+                record.holdCount, record.lineClearCount,
+                record.currentCombo, record.maxCombo,
+                record.frames
+        };
+    }
+
+    inline TSpinCandidate toCandidate(const TSpinRecord &record) {
+        return TSpinCandidate{
+                record.currentIndex,
+                record.holdIndex, record.leftLine,
+                record.depth, record.softdropCount,
+                record.holdCount, record.lineClearCount,
+                record.currentCombo, record.maxCombo,
+                record.tSpinAttack, record.b2b,
+                record.leftNumOfT, record.frames
+        };
+    }
+
+    inline AllSpinsCandidate toCandidate(const AllSpinsRecord &record) {
+        return AllSpinsCandidate{
+                record.currentIndex,
+                record.holdIndex, record.leftLine,
+                record.depth, record.softdropCount,
+                record.holdCount, record.lineClearCount,
+                record.currentCombo, record.maxCombo,
+                record.spinAttack, record.b2b,
+                record.frames
+        };
+    }
+
+    inline TETRIOS2Candidate toCandidate(const TETRIOS2Record &record) {
+        return TETRIOS2Candidate{
+                record.currentIndex,
+                record.holdIndex, record.leftLine,
+                record.depth, record.softdropCount,
+                record.holdCount, record.lineClearCount,
+                record.currentCombo, record.maxCombo,
+                record.spinAttack, record.b2b,
+                record.frames, record.isClean, record.isFlatI
+        };
+    }
 }
 
 #endif //FINDER_TYPES_HPP
@@ -1,12 +1,23 @@
-#include "Windows.h"
+﻿#include "Windows.h"
 #define DLL extern "C" __declspec(dllexport)
 
+#include <algorithm>
+#include <mutex>
 #include <sstream>
 #include <vector>
 
 #include "callback.hpp"
 #include "core/field.hpp"
+#include "core/flood_moves.hpp"
+#include "finder/move_cache.hpp"
+#include "finder/search_arena.hpp"
+#include "finder/search_stats.hpp"
 #include "finder/thread_pool.hpp"
+#include "finder/trace.hpp"
+#include "finder/transposition_table.hpp"
+#include "finder/cancellation.hpp"
+#include "finder/pc_database.hpp"
+#include "finder/query_profile.hpp"
 #include "finder/concurrent_perfect_clear.hpp"
 
 static const unsigned char BitsSetTable256[256] =
@@ -23,18 +34,74 @@ enum Game {
 	TETRIO = 2
 };
 
-using PPTFinder = finder::ConcurrentPerfectClearFinder<false, true>;
-using TETRIOFinder = finder::ConcurrentPerfectClearFinder<true, false>;
+using PPTFinder = finder::ConcurrentPerfectClearFinder<false, true, finder::CachedMoveGenerator<core::srs_flood::MoveGenerator<false, true>>>;
+using TETRIOFinder = finder::ConcurrentPerfectClearFinder<true, false, finder::CachedMoveGenerator<core::srs_flood::MoveGenerator<true, false>>>;
 
-auto srs = core::Factory::create();
-auto srsPlus = core::Factory::createForSRSPlus();
+const auto &srs = core::Factory::create();
+const auto &srsPlus = core::Factory::createForSRSPlus();
 
-auto threadPool = finder::ThreadPool(1);
+auto threadPool = finder::ThreadPool(finder::ThreadPool::kAuto);
+auto transpositionTable = finder::TranspositionTable(finder::TranspositionTable::kDefaultMegabytes);
+finder::CancellationToken cancellation{};
+finder::PCDatabase database{};
+unsigned int timeout = 0;
+bool speculative = false;
+
+// Held for the whole of a search, so that what the workers read is not replaced under them
+std::mutex searchMutex{};
 
 std::optional<PPTFinder> pptfinder;
 std::optional<TETRIOFinder> tetriofinder;
 Game game = Game::None;
 
+finder::QueryTimes lastQueryTimes{};
+finder::RollingLatencyHistogram latencies{};
+
+// More than this are not kept, so that the solutions of a query stay small
+constexpr unsigned int kMaxTopK = 100;
+unsigned int topK = 1;
+std::vector<finder::Solution> lastSolutions{};
+SolutionCallback solutionCallback = nullptr;
+std::mutex solutionCallbackMutex{};
+
+// Operations as "piece,x,y,rotation|", as `action` writes them
+std::string formatSolution(const finder::Solution& solution) {
+	std::stringstream out;
+
+	for (const auto& item : solution) {
+		out << item.pieceType << ","
+			<< item.x << ","
+			<< item.y << ","
+			<< item.rotateType << "|";
+	}
+
+	return out.str();
+}
+
+// Passes the number of solutions to keep and the callback to the finder of the game, before it searches
+template<class F>
+void prepare(F& pcFinder, unsigned int k, bool stream) {
+	pcFinder.setTopK(static_cast<int>(k));
+
+	if (!stream || solutionCallback == nullptr) {
+		pcFinder.setListener(nullptr);
+		return;
+	}
+
+	pcFinder.setListener([callback = solutionCallback](const finder::Solution& solution) {
+		auto text = formatSolution(solution);
+
+		// The workers find solutions at the same time, but the callback is called one at a time
+		std::lock_guard<std::mutex> lock(solutionCallbackMutex);
+		callback(text.c_str());
+	});
+}
+
+void prepareFinder(unsigned int k, bool stream) {
+	if (game == Game::PPT) prepare(*pptfinder, k, stream);
+	if (game == Game::TETRIO) prepare(*tetriofinder, k, stream);
+}
+
 DLL void set_abort(Callback handler) {
 	Abort = handler;
 }
@@ -44,9 +111,9 @@ DLL bool init_finder(Game init) {
 	if (game > Game::None) return true;
 
 	if (init == Game::PPT) {
-		pptfinder.emplace(srs, threadPool);
+		pptfinder.emplace(srs, threadPool, transpositionTable, cancellation, database);
 	} else if (init == Game::TETRIO) {
-		tetriofinder.emplace(srsPlus, threadPool);
+		tetriofinder.emplace(srsPlus, threadPool, transpositionTable, cancellation, database);
 	} else {
 		return false;
 	}
@@ -55,8 +122,179 @@ DLL bool init_finder(Game init) {
 	return true;
 }
 
+// Resizes the pool without stopping the running search. 0 uses one thread per hardware thread, less the reserved one
 DLL void set_threads(unsigned int threads) {
-	threadPool.changeThreadCount(threads);
+	threadPool.changeThreadCount(static_cast<int>(threads));
+}
+
+// Pins each worker to its own hardware thread, and keeps the first one for the caller
+DLL void set_thread_placement(bool pin, bool reserve_core) {
+	threadPool.changePlacement(finder::ThreadPlacement{ pin, reserve_core });
+}
+
+// 0 disables the transposition table. Waits for the running search to end
+DLL void set_table_size(unsigned int megabytes) {
+	std::lock_guard<std::mutex> lock(searchMutex);
+	transpositionTable.resize(megabytes);
+}
+
+// Stops the running search without waiting for the abort callback to be polled
+DLL void cancel_search() {
+	cancellation.cancel();
+}
+
+// Clears a cancel left over from the previous search. The host calls it once per query, before it starts the search
+// and before it lets `cancel_search` reach it, so that a late cancel of the previous query does not stop the next one
+DLL void reset_cancel() {
+	cancellation.reset(0);
+}
+
+// Gives up each following search after `milliseconds`. 0 disables the timeout
+DLL void set_timeout(unsigned int milliseconds) {
+	timeout = milliseconds;
+}
+
+// Maps a database made by `generate_database` for the current game, to answer the queries it covers without searching.
+// Waits for the running search to end
+DLL bool load_database(const char* path) {
+	if (game == Game::None) return false;
+
+	std::lock_guard<std::mutex> lock(searchMutex);
+
+	return database.open(path, game);
+}
+
+// Searches every queue of `pieces` pieces on the field, and appends the results to the database file.
+// `pieces` includes the one left in hold, or equals the number of pieces to place to use them all.
+// The loaded database is closed. Returns false if the file cannot be written or the search is cancelled.
+// Waits for the running search to end, and searches wait for the generation.
+// `cancel_search` stops it, so the host clears the token with `reset_cancel` first, as before a search
+DLL bool generate_database(
+	const char* path, const char* _field, int height, int pieces, int searchtype,
+	bool holdEmpty, bool swap, int combo, bool b2b
+) {
+	if (game == Game::None) return false;
+
+	std::lock_guard<std::mutex> lock(searchMutex);
+
+	database.close();
+
+	// The database only keeps the best solution
+	prepareFinder(1, false);
+
+	auto field = core::createField(_field);
+	auto parameters = finder::PCDatabase::Parameters{ searchtype, holdEmpty, !swap, b2b, combo };
+
+	return finder::PCDatabase::generate(
+		path, game, field, height, pieces, parameters,
+		[&](const std::vector<core::PieceType>& queue, finder::Solution& solution) {
+			solution = game == Game::PPT
+				? pptfinder->run(field, queue, height, holdEmpty, true, !swap, searchtype, combo, b2b, false, 6)
+				: tetriofinder->run(field, queue, height, holdEmpty, true, !swap, searchtype, combo, b2b, false, 6);
+
+			return !cancellation.cancelled();
+		}
+	);
+}
+
+// Number of move generations answered by the move cache and not, since the DLL was loaded
+DLL void get_move_cache_stats(uint64_t* hits, uint64_t* misses) {
+	auto stats = finder::MoveCache::stats();
+	*hits = stats.hits;
+	*misses = stats.misses;
+}
+
+// Number of searches run by the threads, and times their arena grew (move buffers grown and task payloads created), since the DLL was loaded.
+// The arena stops growing once it is warm, whatever the number of nodes. Other heap allocations are not counted
+DLL void get_arena_growth(uint64_t* searches, uint64_t* growths) {
+	auto stats = finder::ArenaGrowth::stats();
+	*searches = stats.searches;
+	*growths = stats.growths;
+}
+
+// What the searches have done since the DLL was loaded: nodes per depth, moves, prunes and the time in each phase.
+// All zero if the DLL is built with FINDER_SEARCH_STATS=0, which `enabled` tells.
+// The times of the phases inside a node are zero unless it is built with FINDER_PHASE_TIMES=1.
+DLL void get_search_stats(finder::SearchStats* stats) {
+	*stats = finder::SearchCounters::stats();
+}
+
+// Where the time of the last `action` call went, in nanoseconds
+DLL void get_query_times(finder::QueryTimes* times) {
+	*times = lastQueryTimes;
+}
+
+// The latency at `percentile` (0 to 100) among the recent `action` calls, in nanoseconds. 0 if none
+DLL uint64_t get_latency_percentile(double percentile) {
+	return latencies.snapshot().percentile(percentile);
+}
+
+// Writes the non-empty buckets of the latency histogram of the recent `action` calls, from the fastest:
+// the largest latency in nanoseconds that each bucket counts, and its count. Returns the number of buckets written
+DLL int get_latency_histogram(uint64_t* upper_bounds, uint64_t* counts, int length) {
+	auto histogram = latencies.snapshot();
+
+	int written = 0;
+	for (int bucket = 0; bucket < finder::LatencyHistogram::kNumOfBuckets && written < length; bucket++) {
+		if (histogram.count(bucket) == 0) continue;
+
+		upper_bounds[written] = finder::LatencyHistogram::upperBoundOf(bucket);
+		counts[written] = histogram.count(bucket);
+		written++;
+	}
+
+	return written;
+}
+
+DLL void reset_latency_histogram() {
+	latencies.clear();
+}
+
+// Records how the thread pool schedules the tasks of each `action` call, to be written by `dump_trace`
+DLL void set_tracing(bool enabled) {
+	finder::Trace::enable(enabled);
+}
+
+// Writes the schedule of the last `action` call as a Chrome trace JSON file, for chrome://tracing or Perfetto.
+// Call it after the call returns. Returns false if the file cannot be written
+DLL bool dump_trace(const char* path) {
+	return finder::Trace::dump(path);
+}
+
+// Searches all heights at the same time instead of one after another
+DLL void set_speculative(bool enabled) {
+	speculative = enabled;
+}
+
+// Keeps the `count` best distinct solutions of each `action` call, to be read by `get_solutions`.
+// 1 keeps only the best, and at most `kMaxTopK` are kept. More prune less, so the search is slower
+DLL void set_top_k(unsigned int count) {
+	topK = std::clamp(count, 1U, kMaxTopK);
+}
+
+// Writes the best distinct solutions of the last `action` call, from the best, each as `action` writes it and ended by ';'.
+// The first one is the solution `action` returned. Only whole solutions that fit in `_len` with the terminator are written.
+// Returns the number of solutions written
+DLL int get_solutions(char* _str, int _len) {
+	std::string all;
+	int written = 0;
+
+	for (const auto& solution : lastSolutions) {
+		auto text = formatSolution(solution) + ";";
+		if (_len <= static_cast<int>(all.length() + text.length())) break;
+
+		all += text;
+		written++;
+	}
+
+	if (0 < _len) std::copy(all.c_str(), all.c_str() + all.length() + 1, _str);
+	return written;
+}
+
+// Calls `callback` with each perfect clear the following searches reach, formatted as `action` writes it.
+// It is called from the worker threads, one call at a time, while `action` runs. Null stops it
+DLL void set_solution_callback(SolutionCallback callback) {
+	solutionCallback = callback;
 }
 
 core::PieceType charToPiece(char x) {
@@ -87,14 +325,46 @@ core::PieceType charToPiece(char x) {
 	}
 }
 
-DLL void action(
+finder::QueryProfile* currentProfile() {
+	if (game == Game::PPT) return &pptfinder->profile();
+	if (game == Game::TETRIO) return &tetriofinder->profile();
+	return nullptr;
+}
+
+// 0 means no deadline
+int64_t deadlineAfter(unsigned int milliseconds) {
+	return 0 < milliseconds ? finder::CancellationToken::now() + milliseconds * 1000000LL : 0;
+}
+
+// Returns whether the search ran to the end, i.e. the result is the best one (or no solution exists).
+// If it was cancelled, the result is the best solution found before then.
+bool find(
 	const char* _field, const char* _queue, const char* _hold, int height,
 	int max_height, bool swap, int searchtype, int combo, bool b2b, bool twoLine,
-	char* _str, int _len
+	char* _str, int _len, int64_t deadline
 ) {
+	std::lock_guard<std::mutex> lock(searchMutex);
+
+	auto start = finder::CancellationToken::now();
+	int64_t formatStart = 0;
+
 	bool solved = false;
 	std::stringstream out;
 
+	// A cancel made before the search started is kept, the host clears the token with `reset_cancel` before each query
+	cancellation.setDeadline(deadline);
+
+	if (finder::Trace::enabled()) {
+		finder::Trace::begin();
+		finder::Trace::name("action");
+	}
+
+	auto profile = currentProfile();
+	if (profile != nullptr) profile->clear();
+
+	lastSolutions.clear();
+	prepareFinder(topK, true);
+
 	if (game > Game::None) {
 		auto field = core::createField(_field);
 
@@ -152,29 +422,42 @@ DLL void action(
 			//	height += 2;
 			//}
 
+			auto heights = std::vector<int>();
+
 			for (; height <= max_height; height += 2) {
 				if ((height * 10 - minos_placed) / 4 + 1 > pieces.size()) break;
 
-				auto result = game == Game::PPT
-					? pptfinder->run(field, pieces, height, holdEmpty, holdAllowed, !swap, searchtype, combo, b2b, twoLine, 6)
-					: (game == Game::TETRIO
-						? tetriofinder->run(field, pieces, height, holdEmpty, holdAllowed, !swap, searchtype, combo, b2b, twoLine, 6)
-						: finder::Solution() // empty solution
-					);
+				heights.push_back(height);
+			}
+
+			auto result = finder::Solution(); // empty solution
 
-				if (!result.empty()) {
-					solved = true;
+			profile->add(finder::QueryPhase::Parse, finder::CancellationToken::now() - start);
 
-					for (const auto& item : result) {
-						out << item.pieceType << ","
-							<< item.x << ","
-							<< item.y << ","
-							<< item.rotateType << "|";
-					}
+			if (speculative) {
+				profile->searched(static_cast<int>(heights.size()));
+				result = game == Game::PPT
+					? pptfinder->run(field, pieces, heights, holdEmpty, holdAllowed, !swap, searchtype, combo, b2b, twoLine, 6)
+					: tetriofinder->run(field, pieces, heights, holdEmpty, holdAllowed, !swap, searchtype, combo, b2b, twoLine, 6);
+			} else {
+				for (int maxLine : heights) {
+					profile->searched(1);
+					result = game == Game::PPT
+						? pptfinder->run(field, pieces, maxLine, holdEmpty, holdAllowed, !swap, searchtype, combo, b2b, twoLine, 6)
+						: tetriofinder->run(field, pieces, maxLine, holdEmpty, holdAllowed, !swap, searchtype, combo, b2b, twoLine, 6);
 
-					break;
+					if (!result.empty()) break;
 				}
 			}
+
+			formatStart = finder::CancellationToken::now();
+
+			if (!result.empty()) {
+				solved = true;
+				out << formatSolution(result);
+
+				lastSolutions = game == Game::PPT ? pptfinder->solutions() : tetriofinder->solutions();
+			}
 		}
 	}
 
@@ -182,6 +465,44 @@ DLL void action(
 
 	std::string a = out.str();
 	std::copy(a.c_str(), a.c_str() + a.length() + 1, _str);
+
+	auto end = finder::CancellationToken::now();
+	if (profile != nullptr) {
+		if (formatStart != 0) profile->add(finder::QueryPhase::Format, end - formatStart);
+		lastQueryTimes = profile->times(end - start);
+	} else {
+		lastQueryTimes = finder::QueryTimes{ static_cast<uint64_t>(end - start) };
+	}
+	latencies.record(end - start);
+
+	// Heights are searched in order and each one to the end unless cancelled,
+	// so an uncancelled result is the best under the search type.
+	return !cancellation.cancelled();
+}
+
+// Returns whether the result is proven to be the best
+DLL bool action(
+	const char* _field, const char* _queue, const char* _hold, int height,
+	int max_height, bool swap, int searchtype, int combo, bool b2b, bool twoLine,
+	char* _str, int _len
+) {
+	return find(
+		_field, _queue, _hold, height, max_height, swap, searchtype, combo, b2b, twoLine,
+		_str, _len, deadlineAfter(timeout)
+	);
+}
+
+// Anytime search: returns the best solution found within `milliseconds` instead of the timeout.
+// Returns whether the result is proven to be the best. 0 means no budget
+DLL bool action_anytime(
+	const char* _field, const char* _queue, const char* _hold, int height,
+	int max_height, bool swap, int searchtype, int combo, bool b2b, bool twoLine,
+	char* _str, int _len, unsigned int milliseconds
+) {
+	return find(
+		_field, _queue, _hold, height, max_height, swap, searchtype, combo, b2b, twoLine,
+		_str, _len, deadlineAfter(milliseconds)
+	);
 }
 
 // Managed code may not be run under loader lock,